@@ -0,0 +1,159 @@
+#include "AnalyserComponent.h"
+
+#include <algorithm>
+#include <cmath>
+
+AnalyserComponent::AnalyserComponent (AnalyserTap& tapToRead)
+    : tap (tapToRead)
+{
+    setOpaque (true);
+    tap.setEnabled (true);
+}
+
+AnalyserComponent::~AnalyserComponent()
+{
+    tap.setEnabled (false);
+}
+
+void AnalyserComponent::update (double sampleRate)
+{
+    int numPulled = 0;
+
+    while (const auto numSamples = tap.pull (pulled.data(), static_cast<int> (pulled.size())))
+    {
+        appendToHistory (pulled.data(), numSamples);
+        numPulled += numSamples;
+    }
+
+    if (numPulled == 0)
+        return;
+
+    currentSampleRate = sampleRate > 0.0 ? sampleRate : 44100.0;
+    computeSpectrum();
+    repaint();
+}
+
+void AnalyserComponent::appendToHistory (const float* newSamples, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        history[static_cast<size_t> (historyPosition)] = newSamples[i];
+        historyPosition = (historyPosition + 1) % fftSize;
+    }
+}
+
+float AnalyserComponent::getHistorySample (int age) const noexcept
+{
+    return history[static_cast<size_t> ((historyPosition - 1 - age + 2 * fftSize) % fftSize)];
+}
+
+// The window is normalised to a mean of 1, so a full-scale sine peaks at fftSize / 2 and reads 0 dB.
+void AnalyserComponent::computeSpectrum()
+{
+    for (int i = 0; i < fftSize; ++i)
+        fftData[static_cast<size_t> (i)] = getHistorySample (fftSize - 1 - i);
+
+    window.multiplyWithWindowingTable (fftData.data(), static_cast<size_t> (fftSize));
+    fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+    const auto scale = 2.0f / static_cast<float> (fftSize);
+
+    for (size_t bin = 0; bin < spectrumDecibels.size(); ++bin)
+        spectrumDecibels[bin] = juce::Decibels::gainToDecibels (fftData[bin] * scale, floorDecibels);
+}
+
+//==============================================================================
+void AnalyserComponent::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colours::black);
+
+    auto bounds = getLocalBounds().toFloat();
+    const auto scopeArea = bounds.removeFromLeft (bounds.getWidth() / 3.0f).reduced (2.0f);
+    const auto spectrumArea = bounds.reduced (2.0f);
+
+    // Grid: the scope's zero line, then every 20 dB and every decade from 100 Hz.
+    g.setColour (juce::Colours::white.withAlpha (0.12f));
+    g.drawHorizontalLine (juce::roundToInt (scopeArea.getCentreY()), scopeArea.getX(), scopeArea.getRight());
+
+    for (auto decibels = -20.0f; decibels > floorDecibels; decibels -= 20.0f)
+        g.drawHorizontalLine (juce::roundToInt (juce::jmap (decibels, floorDecibels, 0.0f, spectrumArea.getBottom(), spectrumArea.getY())),
+                              spectrumArea.getX(), spectrumArea.getRight());
+
+    const auto nyquist = static_cast<float> (currentSampleRate * 0.5);
+
+    for (auto frequency = 100.0f; frequency < nyquist; frequency *= 10.0f)
+    {
+        const auto proportion = std::log (frequency / lowestFrequency) / std::log (nyquist / lowestFrequency);
+        g.drawVerticalLine (juce::roundToInt (spectrumArea.getX() + proportion * spectrumArea.getWidth()),
+                            spectrumArea.getY(), spectrumArea.getBottom());
+    }
+
+    g.setColour (juce::Colours::cyan);
+    g.strokePath (createScopePath (scopeArea), juce::PathStrokeType (1.0f));
+
+    g.setColour (juce::Colours::orange);
+    g.strokePath (createSpectrumPath (spectrumArea), juce::PathStrokeType (1.0f));
+}
+
+// Starts at a rising zero crossing when there is one, so a steady note holds still on the scope.
+juce::Path AnalyserComponent::createScopePath (juce::Rectangle<float> area) const
+{
+    int start = scopeSize - 1;
+
+    for (int age = scopeSize - 1; age < 2 * scopeSize; ++age)
+    {
+        if (getHistorySample (age + 1) <= 0.0f && getHistorySample (age) > 0.0f)
+        {
+            start = age;
+            break;
+        }
+    }
+
+    juce::Path path;
+
+    for (int i = 0; i < scopeSize; ++i)
+    {
+        const auto x = area.getX() + area.getWidth() * static_cast<float> (i) / static_cast<float> (scopeSize - 1);
+        const auto y = area.getCentreY() - juce::jlimit (-1.0f, 1.0f, getHistorySample (start - i)) * area.getHeight() * 0.5f;
+
+        if (i == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+
+    return path;
+}
+
+// One point per pixel column on a log frequency axis, at the loudest bin the column covers.
+juce::Path AnalyserComponent::createSpectrumPath (juce::Rectangle<float> area) const
+{
+    juce::Path path;
+    const auto numColumns = juce::jmax (1, juce::roundToInt (area.getWidth()));
+    const auto nyquist = currentSampleRate * 0.5;
+    const auto binsPerHertz = static_cast<double> (fftSize) / currentSampleRate;
+    const auto lastBin = static_cast<int> (spectrumDecibels.size()) - 1;
+
+    const auto binAt = [&] (int column)
+    {
+        const auto frequency = lowestFrequency * std::pow (nyquist / lowestFrequency, static_cast<double> (column) / numColumns);
+        return juce::jlimit (0, lastBin, static_cast<int> (frequency * binsPerHertz));
+    };
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        const auto firstBin = binAt (column);
+        const auto endBin = juce::jmax (firstBin + 1, binAt (column + 1));
+        const auto loudest = *std::max_element (spectrumDecibels.begin() + firstBin, spectrumDecibels.begin() + juce::jmin (endBin, lastBin + 1));
+
+        const auto x = area.getX() + static_cast<float> (column);
+        const auto y = juce::jmap (juce::jmin (loudest, 0.0f), floorDecibels, 0.0f, area.getBottom(), area.getY());
+
+        if (column == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+
+    return path;
+}
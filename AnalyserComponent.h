@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AnalyserTap.h"
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <vector>
+
+//==============================================================================
+// Scope and spectrum of the processor's output, read from its AnalyserTap, which the component keeps switched on
+// for as long as it exists. The owner calls update() once per frame on the message thread: it drains the tap into
+// a history of the newest fftSize samples, runs a Hann-windowed FFT over them and repaints if anything arrived.
+// The spectrum reaches down to -120 dB, so alias products well under the partials still show.
+class AnalyserComponent final : public juce::Component
+{
+public:
+    explicit AnalyserComponent (AnalyserTap& tapToRead);
+    ~AnalyserComponent() override;
+
+    void update (double sampleRate);
+    void paint (juce::Graphics& g) override;
+
+private:
+    static constexpr int fftOrder = 12;                 // 4096 points: 11.7 Hz bins at 48 kHz.
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int scopeSize = 512;               // Samples across the scope.
+    static constexpr float floorDecibels = -120.0f;
+    static constexpr float lowestFrequency = 20.0f;
+
+    void appendToHistory (const float* newSamples, int numSamples) noexcept;
+    float getHistorySample (int age) const noexcept;    // 0 is the newest.
+    void computeSpectrum();
+    juce::Path createScopePath (juce::Rectangle<float> area) const;
+    juce::Path createSpectrumPath (juce::Rectangle<float> area) const;
+
+    AnalyserTap& tap;
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { static_cast<size_t> (fftSize), juce::dsp::WindowingFunction<float>::hann };
+    std::vector<float> history = std::vector<float> (static_cast<size_t> (fftSize));       // Circular.
+    int historyPosition = 0;                                                                // Where the next sample goes.
+    std::vector<float> pulled = std::vector<float> (static_cast<size_t> (fftSize));
+    std::vector<float> fftData = std::vector<float> (static_cast<size_t> (2 * fftSize));    // performFrequencyOnlyForwardTransform() needs twice the size.
+    std::vector<float> spectrumDecibels = std::vector<float> (static_cast<size_t> (fftSize / 2 + 1), floorDecibels);
+    double currentSampleRate = 44100.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyserComponent)
+};
@@ -0,0 +1,21 @@
+#include "AnalyserTap.h"
+
+#include <algorithm>
+
+void AnalyserTap::setEnabled (bool shouldBeEnabled) noexcept
+{
+    if (shouldBeEnabled && ! isEnabled())
+        fifo.read (fifo.getNumReady());   // The read scope marks them read as it ends.
+
+    enabled.store (shouldBeEnabled, std::memory_order_relaxed);
+}
+
+int AnalyserTap::pull (float* destination, int maxSamples) noexcept
+{
+    const auto scope = fifo.read (juce::jmin (maxSamples, fifo.getNumReady()));
+
+    std::copy_n (samples.data() + scope.startIndex1, scope.blockSize1, destination);
+    std::copy_n (samples.data() + scope.startIndex2, scope.blockSize2, destination + scope.blockSize1);
+
+    return scope.blockSize1 + scope.blockSize2;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+// The processor's finished output, mixed to mono, for the editor's scope and spectrum analyser. The audio thread
+// is the only writer and the message thread the only reader of a single-producer/single-consumer AbstractFifo.
+// Writing is wait-free: samples that don't fit are dropped and counted, never waited for. The tap is off unless
+// an editor turns it on, and then costs the audio thread one atomic load per block.
+class AnalyserTap final
+{
+public:
+    static constexpr int capacity = 32768;   // About 0.7 s at 48 kHz; the editor drains it every frame.
+
+    // Message thread. Turning the tap on drops whatever an earlier editor left unread.
+    void setEnabled (bool shouldBeEnabled) noexcept;
+    bool isEnabled() const noexcept                 { return enabled.load (std::memory_order_relaxed); }
+
+    // Audio thread: appends numSamples of the buffer's first numChannels channels, averaged.
+    template <typename SampleType>
+    void push (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept;
+
+    // Message thread: moves up to maxSamples of the oldest unread samples into destination; returns how many.
+    int pull (float* destination, int maxSamples) noexcept;
+
+    juce::int64 getNumDroppedSamples() const noexcept { return numDroppedSamples.load (std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<float, capacity> samples {};
+    std::atomic<bool> enabled { false };
+    std::atomic<juce::int64> numDroppedSamples { 0 };
+};
+
+//==============================================================================
+template <typename SampleType>
+void AnalyserTap::push (const juce::AudioBuffer<SampleType>& buffer, int numChannels, int numSamples) noexcept
+{
+    if (! enabled.load (std::memory_order_relaxed))
+        return;
+
+    numChannels = juce::jmin (numChannels, buffer.getNumChannels());
+
+    if (numChannels <= 0 || numSamples <= 0)
+        return;
+
+    const auto scale = 1.0f / static_cast<float> (numChannels);
+    const auto* const* channels = buffer.getArrayOfReadPointers();
+    const auto scope = fifo.write (numSamples);
+    const auto numWritten = scope.blockSize1 + scope.blockSize2;
+
+    int sourceIndex = 0;
+
+    scope.forEach ([&] (int index)
+    {
+        float sum = 0.0f;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            sum += static_cast<float> (channels[channel][sourceIndex]);
+
+        samples[static_cast<size_t> (index)] = sum * scale;
+        ++sourceIndex;
+    });
+
+    if (numWritten < numSamples)
+        numDroppedSamples.fetch_add (numSamples - numWritten, std::memory_order_relaxed);
+}
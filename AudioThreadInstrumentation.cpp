@@ -0,0 +1,93 @@
+#include "AudioThreadInstrumentation.h"
+
+namespace
+{
+constexpr int timerHz = 10;
+}
+
+AudioThreadInstrumentation::AudioThreadInstrumentation()
+{
+    startTimerHz (timerHz);
+}
+
+AudioThreadInstrumentation::~AudioThreadInstrumentation()
+{
+    stopTimer();
+}
+
+void AudioThreadInstrumentation::prepare (double sampleRate) noexcept
+{
+    currentSampleRate.store (sampleRate > 0.0 ? sampleRate : 44100.0);
+    numBlocks.store (0);
+    numOverruns.store (0);
+    numDroppedRecords.store (0);
+}
+
+// Wait-free: one fifo reservation, one copy and a few relaxed counter updates.
+void AudioThreadInstrumentation::push (BlockRecord record) noexcept
+{
+    record.blockIndex = numBlocks.fetch_add (1, std::memory_order_relaxed);
+
+    const auto budgetTicks = ticksPerSecond * record.numSamples / currentSampleRate.load (std::memory_order_relaxed);
+
+    if (static_cast<double> (record.totalTicks) > budgetTicks)
+        numOverruns.fetch_add (1, std::memory_order_relaxed);
+
+    const auto scope = fifo.write (1);
+
+    if (scope.blockSize1 > 0)
+        records[static_cast<size_t> (scope.startIndex1)] = record;
+    else
+        numDroppedRecords.fetch_add (1, std::memory_order_relaxed);
+}
+
+void AudioThreadInstrumentation::timerCallback()
+{
+    const auto sampleRate = currentSampleRate.load (std::memory_order_relaxed);
+    const auto microsecondsPerTick = 1.0e6 / ticksPerSecond;
+
+    double loadSum = 0.0, peakLoad = 0.0, midiSum = 0.0, renderSum = 0.0, mixSum = 0.0;
+    int numRead = 0, lastVoices = summary.activeVoices;
+
+    auto scope = fifo.read (fifo.getNumReady());
+
+    scope.forEach ([&] (int index)
+    {
+        const auto& record = records[static_cast<size_t> (index)];
+        const auto budgetTicks = juce::jmax (1.0, ticksPerSecond * record.numSamples / sampleRate);
+        const auto load = static_cast<double> (record.totalTicks) / budgetTicks;
+
+        loadSum += load;
+        peakLoad = juce::jmax (peakLoad, load);
+        midiSum += static_cast<double> (record.midiTicks);
+        renderSum += static_cast<double> (record.renderTicks);
+        mixSum += static_cast<double> (record.mixTicks);
+        lastVoices = record.activeVoices;
+        ++numRead;
+    });
+
+    if (numRead > 0)
+    {
+        summary.averageLoad = loadSum / numRead;
+        summary.peakLoad = peakLoad;
+        summary.midiMicroseconds = midiSum * microsecondsPerTick / numRead;
+        summary.renderMicroseconds = renderSum * microsecondsPerTick / numRead;
+        summary.mixMicroseconds = mixSum * microsecondsPerTick / numRead;
+        summary.activeVoices = lastVoices;
+    }
+
+    summary.numBlocks = numBlocks.load (std::memory_order_relaxed);
+    summary.numOverruns = numOverruns.load (std::memory_order_relaxed);
+    summary.numDroppedRecords = numDroppedRecords.load (std::memory_order_relaxed);
+
+    if (loggingEnabled && ++callbacksSinceLog >= timerHz)
+    {
+        callbacksSinceLog = 0;
+        juce::Logger::writeToLog (juce::String::formatted ("DPlugin DSP load %.1f %% (peak %.1f %%), midi %.1f us, render %.1f us, mix %.1f us, "
+                                                           "%d voices, %lld overruns, %lld dropped",
+                                                           summary.averageLoad * 100.0, summary.peakLoad * 100.0,
+                                                           summary.midiMicroseconds, summary.renderMicroseconds, summary.mixMicroseconds,
+                                                           summary.activeVoices, static_cast<long long> (summary.numOverruns),
+                                                           static_cast<long long> (summary.numDroppedRecords)));
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+// Per-block timing of processBlock(), recorded on the audio thread without locking or allocating.
+// The audio thread pushes one BlockRecord per block into a single-producer/single-consumer AbstractFifo;
+// if the fifo is full the record is dropped and only counted. The fifo's only reader is a message-thread
+// timer that folds records into a Summary for the editor and, optionally, writes it to juce::Logger once
+// per second. Times are juce::Time high-resolution ticks.
+class AudioThreadInstrumentation final : private juce::Timer
+{
+public:
+    struct BlockRecord
+    {
+        juce::int64 blockIndex = 0;
+        int numSamples = 0;
+        int activeVoices = 0;
+        juce::int64 midiTicks = 0;     // Keyboard-state merge.
+        juce::int64 renderTicks = 0;   // synth.renderNextBlock(): MIDI handling and all voices.
+        juce::int64 mixTicks = 0;      // Output gain and decimation.
+        juce::int64 totalTicks = 0;
+    };
+
+    struct Summary
+    {
+        double averageLoad = 0.0;   // Share of the real-time budget, averaged over the last timer period.
+        double peakLoad = 0.0;      // Worst single block over the last timer period.
+        double midiMicroseconds = 0.0, renderMicroseconds = 0.0, mixMicroseconds = 0.0;   // Per-block averages.
+        int activeVoices = 0;
+        juce::int64 numBlocks = 0, numOverruns = 0, numDroppedRecords = 0;   // Since prepare().
+    };
+
+    AudioThreadInstrumentation();
+    ~AudioThreadInstrumentation() override;
+
+    // Call before audio starts; resets every counter.
+    void prepare (double sampleRate) noexcept;
+
+    //==============================================================================
+    // Audio thread: stamps the stage boundaries of one processBlock() call. Stages add up, so a block that is
+    // rendered in several chunks can stamp them once per chunk.
+    class BlockScope
+    {
+    public:
+        explicit BlockScope (AudioThreadInstrumentation& ownerToUse) noexcept
+            : owner (ownerToUse), start (juce::Time::getHighResolutionTicks()), last (start) {}
+
+        void midiMerged() noexcept      { record.midiTicks += lap(); }
+        void voicesRendered() noexcept  { record.renderTicks += lap(); }
+        void outputMixed() noexcept     { record.mixTicks += lap(); }
+
+        void finish (int numSamples, int activeVoices) noexcept
+        {
+            record.totalTicks = juce::Time::getHighResolutionTicks() - start;
+            record.numSamples = numSamples;
+            record.activeVoices = activeVoices;
+            owner.push (record);
+        }
+
+    private:
+        juce::int64 lap() noexcept
+        {
+            const auto now = juce::Time::getHighResolutionTicks();
+            const auto elapsed = now - last;
+            last = now;
+            return elapsed;
+        }
+
+        AudioThreadInstrumentation& owner;
+        const juce::int64 start;
+        juce::int64 last;
+        BlockRecord record;
+    };
+
+    //==============================================================================
+    // Message thread.
+    const Summary& getSummary() const noexcept   { return summary; }
+    void setLoggingEnabled (bool shouldLog) noexcept { loggingEnabled = shouldLog; }
+
+private:
+    static constexpr int capacity = 512;   // About 1.4 s of 128-sample blocks at 48 kHz between timer callbacks.
+
+    void push (BlockRecord record) noexcept;
+    void timerCallback() override;
+
+    juce::AbstractFifo fifo { capacity };
+    std::array<BlockRecord, capacity> records;
+
+    std::atomic<double> currentSampleRate { 44100.0 };
+    std::atomic<juce::int64> numBlocks { 0 }, numOverruns { 0 }, numDroppedRecords { 0 };
+    const double ticksPerSecond = static_cast<double> (juce::Time::getHighResolutionTicksPerSecond());
+
+    Summary summary;
+    bool loggingEnabled = false;
+    int callbacksSinceLog = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioThreadInstrumentation)
+};
@@ -0,0 +1,534 @@
+#include "PluginProcessor.h"
+#include "ParameterIDs.h"
+#include "PulseVoiceBank.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// Offline micro-benchmark for the DSP kernels and the full processor.
+// Nothing here runs in the plugin; it gives a per-build baseline to compare against before deployment.
+//
+// --save-baseline writes the processor timings to a text file, one "<key> <ns/sample/voice>" per line; a later run
+// with --baseline reads it back and fails when any timing is more than --max-regression percent (default 10)
+// slower. Only compare runs with the same options on the same machine: the file records the options as a comment.
+//
+// Exit codes: 0 = done (and within the baseline, if given), 1 = regression against the baseline, 2 = usage or I/O error.
+
+namespace
+{
+struct Settings
+{
+    int numVoices = 32;
+    int eventsPerBlock = 0;   // Extra note-ons/offs spread over every processor block, as from an arpeggiator.
+    int numBlocks = 2000;
+    int numWorkers = 0;
+    int quality = 1;   // Index into qualityNames, i.e. the Quality parameter's choices.
+    int unisonVoices = 1;   // Unison layers per note; above 1 every voice renders its own stack.
+    int engine = 0;   // Index into engineNames, i.e. the Oscillator parameter's choices.
+    bool useVoiceBank = true;
+    bool useFusedKernels = true;   // Voices outside the bank fuse gain, filter and mix into one pass.
+    bool offline = false;   // Processor runs as in an offline bounce, i.e. on the render engine.
+    bool doublePrecision = false;   // Processor is driven through processBlock (AudioBuffer<double>&).
+    std::vector<double> sampleRates { 48000.0 };
+    std::vector<int> blockSizes { 64, 128, 512 };
+    juce::File baselineFile, saveBaselineFile;
+    double maxRegressionPercent = 10.0;
+};
+
+const juce::StringArray qualityNames { "draft", "live", "render" };
+const juce::StringArray engineNames { "fm", "wavetable" };
+
+// Wall clock plus, on x86, the time-stamp counter. TSC ticks are nominal cycles: turbo and frequency scaling
+// are not accounted for, so compare cycle counts between runs on the same machine only.
+class Stopwatch
+{
+public:
+    Stopwatch() noexcept : startTime (Clock::now()), startCycles (readCycleCounter()) {}
+
+    double getNanoseconds() const noexcept { return std::chrono::duration<double, std::nano> (Clock::now() - startTime).count(); }
+    double getCycles() const noexcept      { return static_cast<double> (readCycleCounter() - startCycles); }
+
+    static constexpr bool hasCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static juce::uint64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return static_cast<juce::uint64> (__rdtsc());
+       #else
+        return 0;
+       #endif
+    }
+
+    Clock::time_point startTime;
+    juce::uint64 startCycles;
+};
+
+struct Timing
+{
+    double nanosecondsPerSample = 0.0;
+    double cyclesPerSample = 0.0;
+};
+
+// Runs render() numBlocks times after a short warm-up; samplesPerCall is what one call produces.
+template <typename RenderFunction>
+Timing timeKernel (RenderFunction&& render, double samplesPerCall, int numBlocks)
+{
+    for (int i = 0; i < juce::jmin (numBlocks, 50); ++i)
+        render();
+
+    const Stopwatch stopwatch;
+
+    for (int i = 0; i < numBlocks; ++i)
+        render();
+
+    const auto numSamples = samplesPerCall * numBlocks;
+    return { stopwatch.getNanoseconds() / numSamples, stopwatch.getCycles() / numSamples };
+}
+
+// Summed into the report so the compiler cannot drop any of the rendering as dead code.
+float checksum = 0.0f;
+
+void printTiming (const char* name, const Timing& timing)
+{
+    if (Stopwatch::hasCycleCounter())
+        std::printf ("  %-30s %9.2f ns/sample %9.1f cycles/sample\n", name, timing.nanosecondsPerSample, timing.cyclesPerSample);
+    else
+        std::printf ("  %-30s %9.2f ns/sample\n", name, timing.nanosecondsPerSample);
+}
+
+//==============================================================================
+void benchmarkKernels (const Settings& settings, double sampleRate, int blockSize)
+{
+    std::printf ("Kernels, %.0f Hz, %d-sample blocks (per voice)\n", sampleRate, blockSize);
+
+    std::vector<float> block (static_cast<size_t> (blockSize));
+    auto* samples = block.data();
+
+    AntiAliasedSawOscillator saw;
+    saw.setFrequency (220.0f, sampleRate);
+    printTiming ("saw processBlock", timeKernel ([&] { saw.processBlock (samples, blockSize); checksum += samples[0]; }, blockSize, settings.numBlocks));
+
+    AntiAliasedPulseOscillator pulse;
+    pulse.setFrequency (220.0f, sampleRate);
+    pulse.setPulseWidth (0.3f);
+    printTiming ("pulse processBlock", timeKernel ([&] { pulse.processBlock (samples, blockSize); checksum += samples[0]; }, blockSize, settings.numBlocks));
+
+    std::vector<double> preciseBlock (static_cast<size_t> (blockSize));
+    auto* preciseSamples = preciseBlock.data();
+    printTiming ("pulse processBlockPrecise", timeKernel ([&] { pulse.processBlockPrecise (preciseSamples, nullptr, blockSize); checksum += static_cast<float> (preciseSamples[0]); }, blockSize, settings.numBlocks));
+
+    // The wavetable engine's pulse at the same settings, for a side-by-side reading.
+    const SawWavetables wavetables;
+    WavetablePulseOscillator tablePulse;
+    tablePulse.setTables (&wavetables);
+    tablePulse.setFrequency (220.0f, sampleRate);
+    tablePulse.setPulseWidth (0.3f);
+    printTiming ("wavetable processBlock", timeKernel ([&] { tablePulse.processBlock (samples, blockSize); checksum += samples[0]; }, blockSize, settings.numBlocks));
+    printTiming ("wavetable processBlockPrecise", timeKernel ([&] { tablePulse.processBlockPrecise (preciseSamples, nullptr, blockSize); checksum += static_cast<float> (preciseSamples[0]); }, blockSize, settings.numBlocks));
+
+    LowPassBiquad biquad;
+    biquad.setCoefficients (juce::IIRCoefficients::makeLowPass (sampleRate, 2000.0));
+    printTiming ("biquad processBlock", timeKernel ([&] { biquad.processBlock (samples, blockSize); checksum += samples[0]; }, blockSize, settings.numBlocks));
+
+    const auto svfCoefficients = LowPassSvf::Coefficients::fromG (static_cast<float> (std::tan (juce::MathConstants<double>::pi * 2000.0 / sampleRate)));
+    LowPassSvf svf;
+    svf.setCoefficients (svfCoefficients);
+    printTiming ("svf processBlock", timeKernel ([&] { svf.processBlock (samples, blockSize); checksum += samples[0]; }, blockSize, settings.numBlocks));
+
+    // The bank is refilled every block, as AntiAliasedSynthesiser does, so the gather/scatter cost is included.
+    std::vector<AntiAliasedPulseOscillator> oscillators (static_cast<size_t> (settings.numVoices));
+    std::vector<LowPassSvf> filters (static_cast<size_t> (settings.numVoices));
+
+    for (size_t i = 0; i < oscillators.size(); ++i)
+    {
+        oscillators[i].setFrequency (110.0f * (1.0f + 0.05f * static_cast<float> (i)), sampleRate);
+        filters[i].setCoefficients (svfCoefficients);
+    }
+
+    PulseVoiceBank bank;
+    bank.prepare (settings.numVoices);
+
+    const auto renderBank = [&]
+    {
+        std::fill (block.begin(), block.end(), 0.0f);
+        bank.clear();
+
+        for (size_t i = 0; i < oscillators.size(); ++i)
+            bank.add (oscillators[i], filters[i], 0.5f);
+
+        bank.process (samples, nullptr, svfCoefficients, nullptr, blockSize);
+
+        for (int lane = 0; lane < bank.getNumVoices(); ++lane)
+            bank.store (lane, oscillators[static_cast<size_t> (lane)], filters[static_cast<size_t> (lane)]);
+
+        checksum += samples[0];
+    };
+
+    // Every instruction set this machine runs, then back to the one the processor benchmarks below use.
+    const auto selectedSet = PulseVoiceBank::getInstructionSet();
+
+    for (const auto set : { PulseVoiceBank::InstructionSet::baseline, PulseVoiceBank::InstructionSet::avx2, PulseVoiceBank::InstructionSet::avx512 })
+    {
+        if (! PulseVoiceBank::setInstructionSet (set))
+            continue;
+
+        const auto name = juce::String ("voice bank (pulse + svf, ") + PulseVoiceBank::getName (set) + ")";
+        printTiming (name.toRawUTF8(), timeKernel (renderBank, static_cast<double> (blockSize) * settings.numVoices, settings.numBlocks));
+    }
+
+    PulseVoiceBank::setInstructionSet (selectedSet);
+}
+
+//==============================================================================
+void setParameter (AudioPluginAudioProcessor& processor, const char* parameterID, float value)
+{
+    if (auto* parameter = processor.getValueTreeState().getParameter (parameterID))
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+// Full processBlock() with numVoices held notes: smoothing, voice allocation, rendering and output gain.
+// With --events, one more voice is enabled and an arpeggiated note retriggers on it during every block.
+template <typename SampleType>
+Timing benchmarkProcessor (const Settings& settings, double sampleRate, int blockSize)
+{
+    AudioPluginAudioProcessor processor;
+    processor.setProcessingPrecision (std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                         : juce::AudioProcessor::singlePrecision);
+    processor.setVoiceBankEnabled (settings.useVoiceBank);
+    processor.setFusedKernelsEnabled (settings.useFusedKernels);
+    processor.setNumRenderWorkers (settings.numWorkers);
+    processor.setNonRealtime (settings.offline);
+    setParameter (processor, polyphonyParamID, static_cast<float> (settings.numVoices + (settings.eventsPerBlock > 0 ? 1 : 0)));
+    setParameter (processor, qualityParamID, static_cast<float> (settings.quality));
+    setParameter (processor, unisonVoicesParamID, static_cast<float> (settings.unisonVoices));
+    setParameter (processor, oscillatorEngineParamID, static_cast<float> (settings.engine));
+
+    processor.setPlayConfigDetails (0, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    juce::AudioBuffer<SampleType> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+
+    // Spread over channels as well as notes so no note-on retriggers a voice that is already sounding.
+    for (int voice = 0; voice < settings.numVoices; ++voice)
+        midi.addEvent (juce::MidiMessage::noteOn (1 + voice / 96, 24 + voice % 96, 0.8f), 0);
+
+    processor.processBlock (buffer, midi);
+
+    const auto processArpeggiatedBlock = [&]
+    {
+        for (int event = 0; event < settings.eventsPerBlock; ++event)
+        {
+            const auto position = event * blockSize / settings.eventsPerBlock;
+            midi.addEvent (event % 2 == 0 ? juce::MidiMessage::noteOn (16, 120, 0.8f) : juce::MidiMessage::noteOff (16, 120), position);
+        }
+
+        processor.processBlock (buffer, midi);
+        checksum += static_cast<float> (buffer.getSample (0, 0));
+    };
+
+    const auto timing = timeKernel (processArpeggiatedBlock,
+                                    static_cast<double> (blockSize) * settings.numVoices, settings.numBlocks);
+
+    // Fraction of one core needed in real time, extrapolated linearly to a full core.
+    const auto realtimeLoad = timing.nanosecondsPerSample * settings.numVoices * sampleRate * 1.0e-9;
+    const auto voicesPerCore = realtimeLoad > 0.0 ? settings.numVoices / realtimeLoad : 0.0;
+
+    std::printf ("  %5d-sample buffer %9.2f ns/sample/voice  %6.2f %% of a core  %8.1f voices/core\n",
+                 blockSize, timing.nanosecondsPerSample, realtimeLoad * 100.0, voicesPerCore);
+
+    processor.releaseResources();
+    return timing;
+}
+
+// An instance with nothing playing, as most instances in a large session are most of the time.
+template <typename SampleType>
+void benchmarkIdleProcessor (const Settings& settings, double sampleRate, int blockSize)
+{
+    AudioPluginAudioProcessor processor;
+    processor.setProcessingPrecision (std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                         : juce::AudioProcessor::singlePrecision);
+    processor.setPlayConfigDetails (0, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    juce::AudioBuffer<SampleType> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+
+    const auto timing = timeKernel ([&] { processor.processBlock (buffer, midi); checksum += static_cast<float> (buffer.getSample (0, 0)); },
+                                    1.0, settings.numBlocks);
+
+    std::printf ("  %5d-sample buffer, idle %9.1f ns/block\n", blockSize, timing.nanosecondsPerSample);
+    processor.releaseResources();
+}
+
+//==============================================================================
+// Constructor cost of the first instance, which starts the shared table build, against the instances after it.
+void benchmarkInstantiation (int numInstances)
+{
+    std::vector<std::unique_ptr<AudioPluginAudioProcessor>> instances;
+    std::vector<double> milliseconds;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        const Stopwatch stopwatch;
+        instances.push_back (std::make_unique<AudioPluginAudioProcessor>());
+        milliseconds.push_back (stopwatch.getNanoseconds() * 1.0e-6);
+    }
+
+    auto later = 0.0;
+
+    for (size_t i = 1; i < milliseconds.size(); ++i)
+        later += milliseconds[i] / static_cast<double> (milliseconds.size() - 1);
+
+    std::printf ("Instantiation: first %.3f ms, next %d %.3f ms each on average\n\n", milliseconds.front(), numInstances - 1, later);
+}
+
+// Host-side state calls: a save, a restore of the state the instance already has, and a restore of a change.
+void benchmarkState (int numIterations)
+{
+    AudioPluginAudioProcessor processor;
+    juce::MemoryBlock state;
+
+    const auto save = timeKernel ([&] { processor.getStateInformation (state); checksum += static_cast<float> (state.getSize()); },
+                                  1.0, numIterations);
+    const auto unchanged = timeKernel ([&] { processor.setStateInformation (state.getData(), static_cast<int> (state.getSize())); },
+                                       1.0, numIterations);
+
+    AudioPluginAudioProcessor other;
+    setParameter (other, gainParamID, -24.0f);
+    juce::MemoryBlock changedState;
+    other.getStateInformation (changedState);
+
+    auto toggle = false;
+    const auto changed = timeKernel ([&]
+    {
+        const auto& block = (toggle = ! toggle) ? changedState : state;
+        processor.setStateInformation (block.getData(), static_cast<int> (block.getSize()));
+    }, 1.0, numIterations);
+
+    std::printf ("State: %d bytes, save %.1f us, unchanged restore %.1f us, changed restore %.1f us\n\n",
+                 static_cast<int> (state.getSize()), save.nanosecondsPerSample * 1.0e-3,
+                 unchanged.nanosecondsPerSample * 1.0e-3, changed.nanosecondsPerSample * 1.0e-3);
+}
+
+//==============================================================================
+// Processor timings by "processor-<rate>-<block size>", in ns/sample/voice.
+using Results = std::map<juce::String, double>;
+
+juce::String getResultKey (double sampleRate, int blockSize)
+{
+    return "processor-" + juce::String (juce::roundToInt (sampleRate)) + "-" + juce::String (blockSize);
+}
+
+bool saveBaseline (const juce::File& file, const juce::String& description, const Results& results)
+{
+    juce::String text ("# " + description + "\n");
+
+    for (const auto& [key, nanoseconds] : results)
+        text << key << " " << juce::String (nanoseconds, 3) << "\n";
+
+    return file.replaceWithText (text);
+}
+
+// Prints every timing the baseline also has and returns false if any regressed by more than the allowed percentage.
+bool compareWithBaseline (const juce::File& file, double maxRegressionPercent, const Results& results)
+{
+    juce::StringArray lines;
+    file.readLines (lines);
+
+    std::printf ("Baseline %s, regression limit %.1f %%\n", file.getFileName().toRawUTF8(), maxRegressionPercent);
+    auto passed = true;
+
+    for (const auto& line : lines)
+    {
+        const auto tokens = juce::StringArray::fromTokens (line.trim(), " \t", {});
+
+        if (tokens.size() != 2 || tokens[0].startsWithChar ('#'))
+            continue;
+
+        const auto result = results.find (tokens[0]);
+        const auto baseline = tokens[1].getDoubleValue();
+
+        if (result == results.end() || baseline <= 0.0)
+            continue;
+
+        const auto change = ((result->second / baseline) - 1.0) * 100.0;
+        const auto regressed = change > maxRegressionPercent;
+        passed = passed && ! regressed;
+
+        std::printf ("  %-26s %9.2f ns now, %9.2f ns baseline  %+7.1f %%%s\n", result->first.toRawUTF8(), result->second,
+                     baseline, change, regressed ? "  REGRESSION" : "");
+    }
+
+    return passed;
+}
+
+juce::String describe (const Settings& settings)
+{
+    return juce::String (settings.numVoices) + " voices x " + juce::String (settings.unisonVoices) + " unison, "
+         + engineNames[settings.engine] + " oscillators, " + juce::String (settings.numBlocks) + " blocks, "
+         + (settings.useVoiceBank ? "voice-bank" : "scalar") + " path (" + PulseVoiceBank::getName (PulseVoiceBank::getInstructionSet()) + "), "
+         + (settings.useFusedKernels ? "fused" : "unfused") + " kernels, " + juce::String (settings.numWorkers) + " render workers, "
+         + (settings.offline ? juce::String ("offline render engine") : qualityNames[settings.quality] + " quality") + ", "
+         + (settings.doublePrecision ? "double" : "single") + " precision";
+}
+
+//==============================================================================
+template <typename Type>
+std::vector<Type> parseList (const juce::String& text, std::vector<Type> fallback)
+{
+    std::vector<Type> values;
+
+    for (const auto& token : juce::StringArray::fromTokens (text, ",", {}))
+        if (const auto value = static_cast<Type> (token.getDoubleValue()); value > 0)
+            values.push_back (value);
+
+    return values.empty() ? fallback : values;
+}
+
+Settings parseSettings (const juce::ArgumentList& args)
+{
+    Settings settings;
+
+    if (args.containsOption ("--voices"))
+        settings.numVoices = juce::jlimit (1, 128, args.getValueForOption ("--voices").getIntValue());
+
+    if (args.containsOption ("--blocks"))
+        settings.numBlocks = juce::jmax (1, args.getValueForOption ("--blocks").getIntValue());
+
+    if (args.containsOption ("--events"))
+        settings.eventsPerBlock = juce::jmax (0, args.getValueForOption ("--events").getIntValue());
+
+    if (args.containsOption ("--workers"))
+        settings.numWorkers = juce::jmax (0, args.getValueForOption ("--workers").getIntValue());
+
+    if (args.containsOption ("--unison"))
+        settings.unisonVoices = juce::jlimit (1, UnisonOscillator::maxLayers, args.getValueForOption ("--unison").getIntValue());
+
+    if (args.containsOption ("--engine"))
+        settings.engine = juce::jmax (0, engineNames.indexOf (args.getValueForOption ("--engine"), true));
+
+    if (args.containsOption ("--quality"))
+        settings.quality = juce::jmax (0, qualityNames.indexOf (args.getValueForOption ("--quality"), true));
+
+    settings.useVoiceBank = ! args.containsOption ("--scalar");
+    settings.useFusedKernels = ! args.containsOption ("--unfused");
+    settings.offline = args.containsOption ("--offline");
+    settings.doublePrecision = args.containsOption ("--double");
+    settings.sampleRates = parseList (args.getValueForOption ("--rates"), settings.sampleRates);
+    settings.blockSizes = parseList (args.getValueForOption ("--block-sizes"), settings.blockSizes);
+
+    if (args.containsOption ("--baseline"))
+        settings.baselineFile = args.getFileForOption ("--baseline");
+
+    if (args.containsOption ("--save-baseline"))
+        settings.saveBaselineFile = args.getFileForOption ("--save-baseline");
+
+    if (args.containsOption ("--max-regression"))
+        settings.maxRegressionPercent = juce::jmax (0.0, args.getValueForOption ("--max-regression").getDoubleValue());
+
+    return settings;
+}
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::printf ("Usage: %s [--voices N] [--blocks M] [--rates 44100,48000] [--block-sizes 64,128,512]\n"
+                     "       [--workers W] [--events E] [--unison U] [--engine fm|wavetable] [--quality draft|live|render]\n"
+                     "       [--scalar] [--unfused] [--offline] [--double] [--isa baseline|sse2|neon|avx2|avx512]\n"
+                     "       [--save-baseline timings.txt] [--baseline timings.txt] [--max-regression 10]\n", args.executableName.toRawUTF8());
+        return 0;
+    }
+
+    // Forces the voice bank's instruction set, as DPLUGIN_ISA does for the plugin.
+    if (args.containsOption ("--isa") && ! PulseVoiceBank::setInstructionSet (args.getValueForOption ("--isa")))
+    {
+        std::printf ("Instruction set '%s' is not available in this build or on this CPU\n", args.getValueForOption ("--isa").toRawUTF8());
+        return 2;
+    }
+
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;   // The processor's parameter state needs a message manager.
+    const auto settings = parseSettings (args);
+
+    if (settings.baselineFile != juce::File() && ! settings.baselineFile.existsAsFile())
+    {
+        std::fprintf (stderr, "cannot find baseline %s\n", settings.baselineFile.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    const auto description = describe (settings);
+    std::printf ("DPlugin benchmark: %s\n\n", description.toRawUTF8());
+
+    benchmarkInstantiation (8);
+    benchmarkState (200);
+
+    // Held for the whole run, so every processor below starts with the tables already built.
+    const juce::SharedResourcePointer<SharedTables> sharedTables;
+    sharedTables->waitForSawWavetables();
+
+    Results results;
+
+    for (const auto sampleRate : settings.sampleRates)
+    {
+        benchmarkKernels (settings, sampleRate, settings.blockSizes.front());
+
+        std::printf ("Processor, %.0f Hz, %d voices\n", sampleRate, settings.numVoices);
+
+        for (const auto blockSize : settings.blockSizes)
+        {
+            const auto timing = settings.doublePrecision ? benchmarkProcessor<double> (settings, sampleRate, blockSize)
+                                                         : benchmarkProcessor<float> (settings, sampleRate, blockSize);
+            results[getResultKey (sampleRate, blockSize)] = timing.nanosecondsPerSample;
+        }
+
+        for (const auto blockSize : settings.blockSizes)
+        {
+            if (settings.doublePrecision)
+                benchmarkIdleProcessor<double> (settings, sampleRate, blockSize);
+            else
+                benchmarkIdleProcessor<float> (settings, sampleRate, blockSize);
+        }
+
+        std::printf ("\n");
+    }
+
+    std::printf ("checksum %g\n", static_cast<double> (checksum));
+
+    if (settings.saveBaselineFile != juce::File() && ! saveBaseline (settings.saveBaselineFile, description, results))
+    {
+        std::fprintf (stderr, "cannot write baseline %s\n", settings.saveBaselineFile.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    if (settings.baselineFile != juce::File())
+        return compareWithBaseline (settings.baselineFile, settings.maxRegressionPercent, results) ? 0 : 1;
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "Decimator.h"
+
+#include <cmath>
+
+namespace
+{
+// Elliptic half-band design in closed form; the series converge after a handful of terms.
+double transitionParameterK (double transitionWidth) noexcept
+{
+    const auto k = std::tan ((1.0 - (transitionWidth * 2.0)) * juce::MathConstants<double>::pi / 4.0);
+    return k * k;
+}
+
+double transitionParameterQ (double k) noexcept
+{
+    const auto root = std::pow (1.0 - (k * k), 0.25);
+    const auto e = 0.5 * (1.0 - root) / (1.0 + root);
+    const auto e4 = e * e * e * e;
+    return e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+}
+
+double designCoefficient (int index, double k, double q, int order) noexcept
+{
+    const auto c = static_cast<double> (index + 1);
+    const auto pi = juce::MathConstants<double>::pi;
+
+    auto numerator = 0.0;
+    auto sign = 1.0;
+
+    for (int i = 0;; ++i, sign = -sign)
+    {
+        const auto term = std::pow (q, i * (i + 1)) * std::sin ((i * 2 + 1) * c * pi / order) * sign;
+        numerator += term;
+
+        if (std::abs (term) < 1.0e-100)
+            break;
+    }
+
+    auto denominator = 0.5;
+    sign = -1.0;
+
+    for (int i = 1;; ++i, sign = -sign)
+    {
+        const auto term = std::pow (q, i * i) * std::cos (i * 2 * c * pi / order) * sign;
+        denominator += term;
+
+        if (std::abs (term) < 1.0e-100)
+            break;
+    }
+
+    const auto ww = numerator * std::pow (q, 0.25) / denominator;
+    const auto wwSquared = ww * ww;
+    const auto x = std::sqrt ((1.0 - wwSquared * k) * (1.0 - wwSquared / k)) / (1.0 + wwSquared);
+    return (1.0 - x) / (1.0 + x);
+}
+
+// Stage designs: the final stage needs a narrow transition band, the 4x front stage a much wider one.
+constexpr int finalStageCoefficients = 8;
+constexpr double finalStageTransition = 0.0233;
+constexpr int firstStageCoefficients = 4;
+constexpr double firstStageTransition = 0.13;
+}
+
+//==============================================================================
+void HalfBandDecimator::prepare (int numCoefficientsToUse, double transitionWidth) noexcept
+{
+    numCoefficients = juce::jlimit (1, maxCoefficients, numCoefficientsToUse);
+
+    const auto k = transitionParameterK (transitionWidth);
+    const auto q = transitionParameterQ (k);
+
+    for (int i = 0; i < numCoefficients; ++i)
+        coefficients[static_cast<size_t> (i)] = static_cast<float> (designCoefficient (i, k, q, numCoefficients * 2 + 1));
+
+    reset();
+}
+
+void HalfBandDecimator::reset() noexcept
+{
+    previousInputs.fill (0.0);
+    previousOutputs.fill (0.0);
+}
+
+void HalfBandDecimator::process (const float* input, float* output, int numOutputSamples) noexcept
+{
+    render (input, output, numOutputSamples);
+}
+
+void HalfBandDecimator::process (const double* input, double* output, int numOutputSamples) noexcept
+{
+    render (input, output, numOutputSamples);
+}
+
+// Even coefficients filter the odd input samples, odd coefficients the even ones; each allpass is
+// y = a * (x - y[-1]) + x[-1] at the output rate.
+template <typename SampleType>
+void HalfBandDecimator::render (const SampleType* input, SampleType* output, int numOutputSamples) noexcept
+{
+    const auto count = static_cast<size_t> (numCoefficients);
+    std::array<SampleType, maxCoefficients> a {}, x {}, y {};
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        a[i] = static_cast<SampleType> (coefficients[i]);
+        x[i] = static_cast<SampleType> (previousInputs[i]);
+        y[i] = static_cast<SampleType> (previousOutputs[i]);
+    }
+
+    const auto allpass = [&] (SampleType in, size_t index) noexcept
+    {
+        const auto result = (a[index] * (in - y[index])) + x[index];
+        x[index] = in;
+        y[index] = result;
+        return result;
+    };
+
+    for (int n = 0; n < numOutputSamples; ++n)
+    {
+        auto odd = input[2 * n + 1];
+        auto even = input[2 * n];
+
+        for (size_t i = 0; i < count; i += 2)
+        {
+            odd = allpass (odd, i);
+
+            if (i + 1 < count)
+                even = allpass (even, i + 1);
+        }
+
+        output[n] = SampleType (0.5) * (odd + even);
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        previousInputs[i] = x[i];
+        previousOutputs[i] = y[i];
+    }
+}
+
+// A first-order allpass (a + z^-1) / (1 + a z^-1) delays DC by (1 - a) / (1 + a) samples. The odd branch
+// starts half an output sample later, and the two branches average.
+double HalfBandDecimator::getLatencyInOutputSamples() const noexcept
+{
+    auto delay = -0.5;
+
+    for (int i = 0; i < numCoefficients; ++i)
+    {
+        const auto a = static_cast<double> (coefficients[static_cast<size_t> (i)]);
+        delay += (1.0 - a) / (1.0 + a);
+    }
+
+    return 0.5 * delay;
+}
+
+//==============================================================================
+void OversamplingDecimator::prepare (int numChannels)
+{
+    channels.resize (static_cast<size_t> (juce::jmax (1, numChannels)));
+
+    for (auto& channel : channels)
+    {
+        channel.firstStage.prepare (firstStageCoefficients, firstStageTransition);
+        channel.finalStage.prepare (finalStageCoefficients, finalStageTransition);
+    }
+}
+
+void OversamplingDecimator::reset() noexcept
+{
+    for (auto& channel : channels)
+    {
+        channel.firstStage.reset();
+        channel.finalStage.reset();
+    }
+}
+
+void OversamplingDecimator::setFactor (int newFactor) noexcept
+{
+    newFactor = newFactor >= maxFactor ? maxFactor : (newFactor >= 2 ? 2 : 1);
+
+    if (newFactor == factor)
+        return;
+
+    factor = newFactor;
+    reset();
+}
+
+void OversamplingDecimator::process (juce::AudioBuffer<float>& oversampled, juce::AudioBuffer<float>& output,
+                                     int outputStart, int numOutputSamples) noexcept
+{
+    render (oversampled, output, outputStart, numOutputSamples);
+}
+
+void OversamplingDecimator::process (juce::AudioBuffer<double>& oversampled, juce::AudioBuffer<double>& output,
+                                     int outputStart, int numOutputSamples) noexcept
+{
+    render (oversampled, output, outputStart, numOutputSamples);
+}
+
+template <typename SampleType>
+void OversamplingDecimator::render (juce::AudioBuffer<SampleType>& oversampled, juce::AudioBuffer<SampleType>& output,
+                                    int outputStart, int numOutputSamples) noexcept
+{
+    jassert (oversampled.getNumSamples() >= numOutputSamples * factor);
+    const auto numChannels = juce::jmin (output.getNumChannels(), oversampled.getNumChannels(), static_cast<int> (channels.size()));
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        auto& channel = channels[static_cast<size_t> (i)];
+        auto* samples = oversampled.getWritePointer (i);
+
+        if (factor == maxFactor)
+            channel.firstStage.process (samples, samples, numOutputSamples * 2);
+
+        if (factor > 1)
+            channel.finalStage.process (samples, samples, numOutputSamples);
+
+        output.copyFrom (i, outputStart, samples, numOutputSamples);
+    }
+}
+
+int OversamplingDecimator::getLatencyInSamples() const noexcept
+{
+    if (factor == 1 || channels.empty())
+        return 0;
+
+    const auto& channel = channels.front();
+    auto latency = channel.finalStage.getLatencyInOutputSamples();
+
+    if (factor == maxFactor)
+        latency += 0.5 * channel.firstStage.getLatencyInOutputSamples();
+
+    return juce::roundToInt (latency);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <vector>
+
+//==============================================================================
+// 2:1 polyphase half-band decimator: two chains of first-order allpasses running at the output rate, one fed
+// the even input samples and one the odd (Valenzuela-Constantinides, as in de Soras' HIIR). Each output sample
+// costs one multiply per coefficient, far less than a half-band FIR with the same stopband. The phase is only
+// non-linear close to the band edge, above 20 kHz, and the latency stays around one output sample.
+class HalfBandDecimator final
+{
+public:
+    static constexpr int maxCoefficients = 8;
+
+    // Designs the allpass coefficients for a transition band of 0.25 +/- transitionWidth of the input rate.
+    void prepare (int numCoefficientsToUse, double transitionWidth) noexcept;
+    void reset() noexcept;
+
+    // Reads 2 * numOutputSamples input samples. output may be input: sample n is written only after input 2n + 1 is read.
+    void process (const float* input, float* output, int numOutputSamples) noexcept;
+    void process (const double* input, double* output, int numOutputSamples) noexcept;
+
+    double getLatencyInOutputSamples() const noexcept;   // Group delay at DC.
+
+private:
+    template <typename SampleType>
+    void render (const SampleType* input, SampleType* output, int numOutputSamples) noexcept;
+
+    // The state is kept in double so either precision can run; the float path rounds it on entry, as the oscillators do.
+    std::array<float, maxCoefficients> coefficients {};
+    std::array<double, maxCoefficients> previousInputs {}, previousOutputs {};
+    int numCoefficients = 0;
+};
+
+//==============================================================================
+// Brings voices rendered at 2x or 4x back to the output rate. There is one decimator chain per output channel,
+// run on the mixed signal, so the cost doesn't grow with the number of voices. The final 2:1 stage is flat to
+// 20 kHz at 44.1 kHz and rejects aliases by 86 dB; 4x puts a short 4:1 -> 2:1 stage (79 dB) in front of it.
+class OversamplingDecimator final
+{
+public:
+    static constexpr int maxFactor = 4;
+
+    void prepare (int numChannels);
+    void reset() noexcept;
+
+    // 1, 2 or 4. Resets the filters when the factor changes; never allocates.
+    void setFactor (int newFactor) noexcept;
+    int getFactor() const noexcept { return factor; }
+
+    // Decimates the first numOutputSamples * factor samples of each oversampled channel (overwriting them) and
+    // copies the result into output at outputStart. At factor 1 this is a plain copy.
+    void process (juce::AudioBuffer<float>& oversampled, juce::AudioBuffer<float>& output,
+                  int outputStart, int numOutputSamples) noexcept;
+    void process (juce::AudioBuffer<double>& oversampled, juce::AudioBuffer<double>& output,
+                  int outputStart, int numOutputSamples) noexcept;
+
+    int getLatencyInSamples() const noexcept;   // Rounded, at the output rate.
+
+    // Output samples the filters keep ringing after their input falls silent, until their output is below -120 dB.
+    int getSettlingTimeInSamples() const noexcept   { return factor == 1 ? 0 : settlingTimeInSamples; }
+
+private:
+    template <typename SampleType>
+    void render (juce::AudioBuffer<SampleType>& oversampled, juce::AudioBuffer<SampleType>& output,
+                 int outputStart, int numOutputSamples) noexcept;
+
+    struct Channel
+    {
+        HalfBandDecimator firstStage;   // 4x -> 2x.
+        HalfBandDecimator finalStage;   // 2x -> 1x.
+    };
+
+    // Measured with noise: the final stage rings for about 340 output samples, the 4:1 front stage for about 30.
+    static constexpr int settlingTimeInSamples = 512;
+
+    std::vector<Channel> channels;
+    int factor = 1;
+};
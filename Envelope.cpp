@@ -0,0 +1,182 @@
+#include "Envelope.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Per-sample multiplier that shrinks a distance by the given ratio over the given time; 0 when the time is zero.
+float coefficientFor (double sampleRate, float seconds, double ratio) noexcept
+{
+    const auto numSamples = static_cast<double> (seconds) * sampleRate;
+
+    if (numSamples < 1.0)
+        return 0.0f;
+
+    return static_cast<float> (std::exp (std::log (ratio) / numSamples));
+}
+
+// Closed-form segment length: samples until start * c^n has shrunk to end. Both distances have the same sign.
+int samplesUntil (double startDistance, double endDistance, float coefficient) noexcept
+{
+    if (coefficient <= 0.0f || std::abs (startDistance) <= std::abs (endDistance))
+        return 0;
+
+    const auto numSamples = std::ceil (std::log (endDistance / startDistance) / std::log (static_cast<double> (coefficient)));
+    return static_cast<int> (juce::jmin (numSamples, static_cast<double> (std::numeric_limits<int>::max())));
+}
+}
+
+//==============================================================================
+SegmentEnvelope::Shape SegmentEnvelope::Shape::fromTimes (double sampleRate, float attackSeconds, float decaySeconds,
+                                                          float sustainLevel, float releaseSeconds) noexcept
+{
+    // From silence the attack covers attackTarget -> attackTarget - 1 in attackSeconds; decay and release cover
+    // full scale -> silenceThreshold in theirs.
+    constexpr auto attackRatio = (attackTarget - 1.0) / attackTarget;
+    constexpr auto fallRatio = static_cast<double> (silenceThreshold);
+
+    Shape result;
+    result.attackCoefficient = coefficientFor (sampleRate, attackSeconds, attackRatio);
+    result.decayCoefficient = coefficientFor (sampleRate, decaySeconds, fallRatio);
+    result.releaseCoefficient = coefficientFor (sampleRate, releaseSeconds, fallRatio);
+    result.sustainLevel = juce::jlimit (0.0f, 1.0f, sustainLevel);
+    return result;
+}
+
+bool SegmentEnvelope::Shape::operator== (const Shape& other) const noexcept
+{
+    return attackCoefficient == other.attackCoefficient && decayCoefficient == other.decayCoefficient
+        && releaseCoefficient == other.releaseCoefficient && sustainLevel == other.sustainLevel;
+}
+
+//==============================================================================
+void SegmentEnvelope::noteOn (const Shape& newShape) noexcept
+{
+    shape = newShape;
+    startSegment (Stage::attack);
+}
+
+void SegmentEnvelope::noteOff (const Shape& newShape) noexcept
+{
+    shape = newShape;
+
+    if (stage != Stage::idle)
+        startSegment (Stage::release);
+}
+
+void SegmentEnvelope::reset() noexcept
+{
+    stage = Stage::idle;
+    level = 0.0f;
+    samplesLeft = 0;
+}
+
+void SegmentEnvelope::setShape (const Shape& newShape) noexcept
+{
+    if (newShape == shape)
+        return;
+
+    shape = newShape;
+
+    if (isMoving())
+        startSegment (stage);
+    else if (stage == Stage::sustain && level != shape.sustainLevel)
+        startSegment (Stage::decay);   // Glide to the new sustain level rather than jumping.
+}
+
+void SegmentEnvelope::startSegment (Stage newStage) noexcept
+{
+    stage = newStage;
+
+    switch (stage)
+    {
+        case Stage::attack:
+            target = attackTarget;
+            coefficient = shape.attackCoefficient;
+            samplesLeft = samplesUntil (level - target, 1.0 - target, coefficient);
+            break;
+
+        case Stage::decay:
+        {
+            target = shape.sustainLevel;
+            coefficient = shape.decayCoefficient;
+            const auto distance = static_cast<double> (level - target);
+            samplesLeft = samplesUntil (distance, std::copysign (static_cast<double> (silenceThreshold), distance), coefficient);
+            break;
+        }
+
+        case Stage::release:
+            target = 0.0f;
+            coefficient = shape.releaseCoefficient;
+            samplesLeft = samplesUntil (level, silenceThreshold, coefficient);
+            break;
+
+        case Stage::sustain:
+        case Stage::idle:
+            samplesLeft = 0;
+            return;
+    }
+
+    if (samplesLeft == 0)
+        finishSegment();
+}
+
+// Snaps to the segment's end value, which is at most silenceThreshold away, and moves on.
+void SegmentEnvelope::finishSegment() noexcept
+{
+    switch (stage)
+    {
+        case Stage::attack:
+            level = 1.0f;
+            startSegment (Stage::decay);
+            break;
+
+        case Stage::decay:
+            level = shape.sustainLevel;
+            stage = Stage::sustain;
+            break;
+
+        case Stage::release:
+            reset();
+            break;
+
+        case Stage::sustain:
+        case Stage::idle:
+            break;
+    }
+}
+
+bool SegmentEnvelope::process (float* gains, float scale, int numSamples) noexcept
+{
+    if (! isMoving())
+        return false;
+
+    auto i = 0;
+
+    while (i < numSamples && isMoving())
+    {
+        const auto run = juce::jmin (numSamples - i, samplesLeft);
+        const auto startDistance = level - target;
+        auto distance = startDistance;
+
+        for (int n = 0; n < run; ++n)
+        {
+            gains[i + n] = scale * (target + distance);
+            distance *= coefficient;
+        }
+
+        i += run;
+        samplesLeft -= run;
+        level = target + static_cast<float> (static_cast<double> (startDistance) * std::pow (static_cast<double> (coefficient), run));
+
+        if (samplesLeft == 0)
+            finishSegment();
+    }
+
+    // The rest of the block holds at the sustain level, or at silence after a release.
+    for (; i < numSamples; ++i)
+        gains[i] = scale * level;
+
+    return true;
+}
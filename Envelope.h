@@ -0,0 +1,63 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+// ADSR amplitude envelope built from exponential segments. Each moving segment approaches a target as
+// level = target + (start - target) * c^n, so a segment's length in samples and its end value are known in
+// closed form when it starts. Within a block the level is stepped with one multiply per sample; at the end of
+// every block it is recomputed from the closed form in double, so long segments never drift.
+//
+// Attack aims past full scale (attackTarget) and is cut off at 1, which gives the usual analogue curve.
+// Decay and release are timed to cover the full scale down to silenceThreshold: a release from full level
+// reaches the threshold after exactly the release time, and the envelope then goes idle.
+class SegmentEnvelope final
+{
+public:
+    static constexpr float silenceThreshold = 1.0e-4f;   // -80 dB; below this a released voice is retired.
+    static constexpr float attackTarget = 1.3f;
+
+    // Per-sample coefficients for one sample rate and set of times. Worked out once per block for every voice.
+    struct Shape
+    {
+        float attackCoefficient = 0.0f;    // Multipliers of the distance to the target; 0 jumps straight there.
+        float decayCoefficient = 0.0f;
+        float releaseCoefficient = 0.0f;
+        float sustainLevel = 1.0f;
+
+        static Shape fromTimes (double sampleRate, float attackSeconds, float decaySeconds,
+                                float sustainLevel, float releaseSeconds) noexcept;
+
+        bool operator== (const Shape& other) const noexcept;
+        bool operator!= (const Shape& other) const noexcept { return ! operator== (other); }
+    };
+
+    void noteOn (const Shape& newShape) noexcept;    // Attacks from the current level, so a retrigger doesn't click.
+    void noteOff (const Shape& newShape) noexcept;   // Releases from the current level.
+    void reset() noexcept;
+
+    // Call once per block before process(). A changed shape bends the running segment from where it is.
+    void setShape (const Shape& newShape) noexcept;
+
+    // Writes scale * level for the next numSamples samples and returns true, or returns false without touching
+    // gains when the level holds still for the whole block (sustain or idle); getLevel() is then that level.
+    bool process (float* gains, float scale, int numSamples) noexcept;
+
+    float getLevel() const noexcept   { return level; }
+    bool isMoving() const noexcept    { return stage == Stage::attack || stage == Stage::decay || stage == Stage::release; }
+    bool isIdle() const noexcept      { return stage == Stage::idle; }
+    bool isSilent() const noexcept    { return stage == Stage::idle || (stage == Stage::sustain && level <= 0.0f); }
+
+private:
+    enum class Stage { idle, attack, decay, sustain, release };
+
+    void startSegment (Stage newStage) noexcept;
+    void finishSegment() noexcept;
+
+    Shape shape;
+    Stage stage = Stage::idle;
+    float level = 0.0f;
+    float target = 0.0f;
+    float coefficient = 0.0f;
+    int samplesLeft = 0;   // Samples until the running segment reaches its end value.
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "PulseKernels.h"
+
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <cmath>
+
+//==============================================================================
+// Fast replacements for std::sin (twoPi * phase) in the feedback-FM saw core, in scalar and SIMD-lane form.
+//
+// Worst-case absolute error, measured over phase in [-2, 2] (wider than phase + osc * beta can reach):
+//   polynomial : 2.1e-7 against the exact sine, 8.3e-7 against std::sin (twoPi * phase) in float.
+//   table      : 1.3e-6 against the exact sine, 1.5e-6 against std::sin (twoPi * phase) in float.
+// Both errors sit at the level of the float rounding of twoPi * phase itself, far below the -120 dB
+// range where the hfCompA0/hfCompA1 compensation or the beta curve could be affected.
+struct FastSine final
+{
+    static constexpr int tableSize = 2048;
+
+    // Default kernel used by the oscillators.
+    static float sinTwoPi (float phase) noexcept
+    {
+       #if DPLUGIN_SINE_KERNEL == DPLUGIN_SINE_KERNEL_TABLE
+        return table (phase);
+       #elif DPLUGIN_SINE_KERNEL == DPLUGIN_SINE_KERNEL_POLYNOMIAL
+        return polynomial (phase);
+       #else
+        return reference (phase);
+       #endif
+    }
+
+    // The original libm path, kept as the accuracy reference.
+    static float reference (float phase) noexcept
+    {
+        return std::sin (juce::MathConstants<float>::twoPi * phase);
+    }
+
+    // Odd degree-9 minimax fit on the quarter wave; the range reduction is branch-free so the lane version below matches it bit for bit.
+    static float polynomial (float phase) noexcept
+    {
+        auto wrapped = phase - std::trunc (phase);                                                   // (-1, 1)
+        const auto above = wrapped > 0.5f ? 1.0f : 0.0f;
+        const auto below = wrapped < -0.5f ? 1.0f : 0.0f;
+        wrapped = (wrapped - above) + below;                                                         // [-0.5, 0.5]
+
+        const auto magnitude = 0.25f - std::abs (std::abs (wrapped) - 0.25f);                      // [0, 0.25]
+        const auto folded = wrapped < 0.0f ? magnitude - (magnitude + magnitude) : magnitude;
+        const auto z = folded * folded;
+
+        using C = PolynomialSine;
+        return folded * (C::c0 + z * (C::c1 + z * (C::c2 + z * (C::c3 + z * C::c4))));
+    }
+
+    //==============================================================================
+    using Lanes = juce::dsp::SIMDRegister<float>;
+
+    // Lane-parallel variant used by the voice bank; tables and libm fall back to one scalar call per lane.
+    static Lanes sinTwoPi (Lanes phase) noexcept
+    {
+       #if DPLUGIN_SINE_KERNEL == DPLUGIN_SINE_KERNEL_POLYNOMIAL
+        return polynomial (phase);
+       #else
+        alignas (Lanes::SIMDRegisterSize) float values[Lanes::SIMDNumElements];
+        phase.copyToRawArray (values);
+
+        for (auto& value : values)
+            value = sinTwoPi (value);
+
+        return Lanes::fromRawArray (values);
+       #endif
+    }
+
+    static Lanes polynomial (Lanes phase) noexcept
+    {
+        return PolynomialSine::sinTwoPi (phase);
+    }
+
+    // Linearly interpolated lookup; the extra guard point avoids a wrap on the upper neighbour.
+    static float table (float phase) noexcept
+    {
+        const auto& values = getTable();
+        const auto position = (phase - std::floor (phase)) * static_cast<float> (tableSize);
+        const auto index = static_cast<int> (position);
+        const auto fraction = position - static_cast<float> (index);
+        const auto wrappedIndex = index & (tableSize - 1);
+
+        return values[(size_t) wrappedIndex] + fraction * (values[(size_t) wrappedIndex + 1] - values[(size_t) wrappedIndex]);
+    }
+
+private:
+    static constexpr double pi = 3.141592653589793238;
+
+    // Taylor series in double on [-pi / 2, pi / 2], where 12 terms are exact to 1e-17; std::sin isn't constexpr.
+    static constexpr double constexprSin (double x) noexcept
+    {
+        if (x > pi / 2.0)
+            x = pi - x;
+        else if (x < -pi / 2.0)
+            x = -pi - x;
+
+        auto term = x, sum = x;
+
+        for (int n = 1; n < 12; ++n)
+        {
+            term *= -(x * x) / static_cast<double> ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // Built at compile time, so neither the first oscillator call nor a new plugin instance pays for it.
+    // The second half of the cycle is evaluated at x - 2 pi, keeping the argument within [-pi, pi].
+    static constexpr std::array<float, tableSize + 1> makeTable() noexcept
+    {
+        std::array<float, tableSize + 1> result {};
+
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            const auto x = 2.0 * pi * static_cast<double> (i) / static_cast<double> (tableSize);
+            result[i] = static_cast<float> (constexprSin (x > pi ? x - (2.0 * pi) : x));
+        }
+
+        return result;
+    }
+
+    static const std::array<float, tableSize + 1>& getTable() noexcept
+    {
+        static constexpr auto values = makeTable();
+        return values;
+    }
+};
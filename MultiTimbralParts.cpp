@@ -0,0 +1,142 @@
+#include "MultiTimbralParts.h"
+
+const juce::Identifier MultiTimbralParts::stateType { "PARTS" };
+
+MultiTimbralParts::MultiTimbralParts (juce::AudioProcessorValueTreeState& parameterState, const SmoothedParameters& mainParameters,
+                                      PresetBank& programs)
+    : main (mainParameters), presets (programs)
+{
+    for (auto& part : parts)
+    {
+        part.values = std::vector<std::atomic<float>> (static_cast<size_t> (presets.getNumSoundParameters()));
+
+        part.smoothed = std::make_unique<SmoothedParameters> ([this, &part, &parameterState] (const char* parameterID)
+        {
+            const auto index = presets.indexOfSoundParameter (parameterID);
+            return index >= 0 ? &part.values[static_cast<size_t> (index)] : parameterState.getRawParameterValue (parameterID);
+        });
+    }
+}
+
+// Every part is prepared, used or not, so the mode can be switched on while playing.
+void MultiTimbralParts::prepare (double sampleRate, int maximumBlockSize, int oversamplingFactor)
+{
+    for (auto& part : parts)
+        part.smoothed->prepare (sampleRate, maximumBlockSize, oversamplingFactor);
+}
+
+void MultiTimbralParts::setOversamplingFactor (int newFactor) noexcept
+{
+    for (auto& part : parts)
+        part.smoothed->setOversamplingFactor (newFactor);
+}
+
+MultiTimbralParts::Part* MultiTimbralParts::getPart (int midiChannel) noexcept
+{
+    return midiChannel >= 2 && midiChannel <= numParts ? &parts[static_cast<size_t> (midiChannel - 2)] : nullptr;
+}
+
+const MultiTimbralParts::Part* MultiTimbralParts::getPart (int midiChannel) const noexcept
+{
+    return midiChannel >= 2 && midiChannel <= numParts ? &parts[static_cast<size_t> (midiChannel - 2)] : nullptr;
+}
+
+void MultiTimbralParts::selectProgram (int midiChannel, int program) noexcept
+{
+    if (auto* part = getPart (midiChannel))
+    {
+        part->program.store (juce::jmax (-1, program));
+        part->pendingProgram.store (juce::jmax (-1, program));
+    }
+}
+
+int MultiTimbralParts::getProgram (int midiChannel) const noexcept
+{
+    const auto* part = getPart (midiChannel);
+    return part != nullptr ? part->program.load() : -1;
+}
+
+// A part taking a program over from the main parameters starts on it; one changing program glides, like the main
+// parameters do. A part going back to following drops its ramps, so notes still playing with it hold still.
+// Programs wait while the bank is still being parsed, as a restored state's will at startup.
+void MultiTimbralParts::applyPendingPrograms() noexcept
+{
+    if (! presets.hasPrograms())
+        return;
+
+    for (auto& part : parts)
+    {
+        const auto program = part.pendingProgram.exchange (noChange);
+
+        if (program == noChange)
+            continue;
+
+        if (program >= 0 && presets.copyProgram (program, part.values.data()))
+        {
+            if (! part.ownsParameters)
+                part.smoothed->snapToParameters();
+
+            part.ownsParameters = true;
+        }
+        else if (program < 0 && part.ownsParameters)
+        {
+            part.smoothed->snapToParameters();
+            part.ownsParameters = false;
+        }
+    }
+}
+
+void MultiTimbralParts::process (int numSamples) noexcept
+{
+    for (auto& part : parts)
+        if (part.ownsParameters)
+            part.smoothed->process (numSamples);
+}
+
+void MultiTimbralParts::saveStates() noexcept
+{
+    for (auto& part : parts)
+        part.smoothed->saveState();
+}
+
+void MultiTimbralParts::restoreStates() noexcept
+{
+    for (auto& part : parts)
+        part.smoothed->restoreState();
+}
+
+const SmoothedParameters& MultiTimbralParts::getParameters (int midiChannel) const noexcept
+{
+    const auto* part = getPart (midiChannel);
+    return part != nullptr && part->ownsParameters ? *part->smoothed : main;
+}
+
+bool MultiTimbralParts::hasOwnParameters (int midiChannel) const noexcept
+{
+    const auto* part = getPart (midiChannel);
+    return part != nullptr && part->ownsParameters;
+}
+
+//==============================================================================
+void MultiTimbralParts::writeState (juce::ValueTree& state) const
+{
+    juce::ValueTree partsState (stateType);
+
+    for (int channel = 2; channel <= numParts; ++channel)
+        if (const auto program = getProgram (channel); program >= 0)
+            partsState.appendChild (juce::ValueTree ("PART", { { "channel", channel }, { "program", program } }), nullptr);
+
+    state.appendChild (partsState, nullptr);
+}
+
+// A state without parts, such as one saved before multi-timbral mode, sets every part back to following.
+void MultiTimbralParts::readState (const juce::ValueTree& state)
+{
+    const auto partsState = state.getChildWithName (stateType);
+
+    for (int channel = 2; channel <= numParts; ++channel)
+    {
+        const auto partState = partsState.getChildWithProperty ("channel", channel);
+        selectProgram (channel, partState.isValid() ? static_cast<int> (partState.getProperty ("program", -1)) : -1);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "PresetBank.h"
+#include "SmoothedParameters.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Multi-timbral mode: one part per MIDI channel, all playing from the synth's one voice pool. Part 1 is the
+// processor's own parameters. Every other part follows them until a program change on its channel gives it a
+// program of its own, which it keeps as a set of raw values and smooths with a SmoothedParameters of its own;
+// the setup parameters (polyphony, quality and the like) stay shared. A part is only those values: there is no
+// parameter tree, host parameter or editor per part.
+class MultiTimbralParts final
+{
+public:
+    static constexpr int numParts = 16;   // One per MIDI channel.
+
+    // The bank is where the parts' programs come from; all three must outlive the parts.
+    MultiTimbralParts (juce::AudioProcessorValueTreeState& parameterState, const SmoothedParameters& mainParameters,
+                       PresetBank& programs);
+
+    void prepare (double sampleRate, int maximumBlockSize, int oversamplingFactor);
+    void setOversamplingFactor (int newFactor) noexcept;
+
+    // Any thread; the audio thread takes it at its next applyPendingPrograms(). -1 makes the part follow the main
+    // parameters again. Channel 1 has no part of its own; its programs are the processor's.
+    void selectProgram (int midiChannel, int program) noexcept;
+    int getProgram (int midiChannel) const noexcept;   // -1 while the part follows the main parameters.
+
+    // Audio thread, once per block before rendering: takes queued programs, then smooths the parts that have one.
+    void applyPendingPrograms() noexcept;
+    void process (int numSamples) noexcept;
+
+    // Every part's SmoothedParameters::saveState() and restoreState(), for the engine crossfade.
+    void saveStates() noexcept;
+    void restoreStates() noexcept;
+
+    // Audio thread. The main parameters for a part that follows them.
+    const SmoothedParameters& getParameters (int midiChannel) const noexcept;
+    bool hasOwnParameters (int midiChannel) const noexcept;
+
+    // The parts' programs, as a child of the processor's saved state tree.
+    static const juce::Identifier stateType;
+    void writeState (juce::ValueTree& state) const;
+    void readState (const juce::ValueTree& state);
+
+private:
+    static constexpr int noChange = -2;
+
+    struct Part
+    {
+        std::vector<std::atomic<float>> values;         // One per sound parameter, in the bank's order.
+        std::unique_ptr<SmoothedParameters> smoothed;   // Reads values, and the shared setup parameters.
+        std::atomic<int> program { -1 };
+        std::atomic<int> pendingProgram { noChange };
+        bool ownsParameters = false;                    // As the audio thread last applied it.
+    };
+
+    Part* getPart (int midiChannel) noexcept;
+    const Part* getPart (int midiChannel) const noexcept;
+
+    const SmoothedParameters& main;
+    PresetBank& presets;
+    std::array<Part, numParts - 1> parts;   // Channels 2 to 16.
+
+    JUCE_DECLARE_NON_COPYABLE (MultiTimbralParts)
+};
@@ -0,0 +1,123 @@
+#include "NoteExpression.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+float ratioFromSemitones (float semitones) noexcept
+{
+    return std::exp2 (semitones / 12.0f);
+}
+}
+
+void NoteExpression::reset (float bendSemitones, float pressureValue, float slideValue) noexcept
+{
+    ramps[pitchBend] = { ratioFromSemitones (bendSemitones), ratioFromSemitones (bendSemitones), 1.0f, 0 };
+    ramps[pressure] = { pressureValue, pressureValue, 0.0f, 0 };
+    ramps[slide] = { slideValue, slideValue, 0.0f, 0 };
+    numEvents = 0;
+    nextEvent = 0;
+}
+
+void NoteExpression::addEvent (Dimension dimension, float value, int samplePosition) noexcept
+{
+    if (numEvents < maxEventsPerBlock)
+    {
+        events[static_cast<size_t> (numEvents++)] = { samplePosition, dimension, value };
+        return;
+    }
+
+    for (auto i = numEvents; --i >= nextEvent;)
+    {
+        if (events[static_cast<size_t> (i)].dimension == dimension)
+        {
+            events[static_cast<size_t> (i)].value = value;
+            return;
+        }
+    }
+}
+
+void NoteExpression::beginBlock() noexcept
+{
+    for (; nextEvent < numEvents; ++nextEvent)
+        startRamp (events[static_cast<size_t> (nextEvent)].dimension, events[static_cast<size_t> (nextEvent)].value);
+
+    numEvents = 0;
+    nextEvent = 0;
+}
+
+bool NoteExpression::isActive() const noexcept
+{
+    if (numEvents > nextEvent)
+        return true;
+
+    for (const auto& ramp : ramps)
+        if (ramp.stepsRemaining > 0)
+            return true;
+
+    return ramps[pitchBend].value != 1.0f || ramps[pressure].value != 0.0f || ramps[slide].value != neutralSlide;
+}
+
+void NoteExpression::startRamp (Dimension dimension, float value) noexcept
+{
+    auto& ramp = ramps[static_cast<size_t> (dimension)];
+    const auto isPitch = dimension == pitchBend;
+    ramp.target = isPitch ? ratioFromSemitones (value) : value;
+
+    if (rampLength <= 1 || ramp.target == ramp.value)
+    {
+        ramp.value = ramp.target;
+        ramp.stepsRemaining = 0;
+        return;
+    }
+
+    ramp.stepsRemaining = rampLength;
+    ramp.step = isPitch ? std::pow (ramp.target / ramp.value, 1.0f / static_cast<float> (rampLength))
+                        : (ramp.target - ramp.value) / static_cast<float> (rampLength);
+}
+
+// Runs between events: each is applied at its own sample, so the buffers are sample accurate.
+void NoteExpression::render (int startSample, int numSamples, float* pitchRatios, float* pressures, float* slides) noexcept
+{
+    const auto endSample = startSample + numSamples;
+
+    for (auto position = startSample; position < endSample;)
+    {
+        for (; nextEvent < numEvents && events[static_cast<size_t> (nextEvent)].position <= position; ++nextEvent)
+            startRamp (events[static_cast<size_t> (nextEvent)].dimension, events[static_cast<size_t> (nextEvent)].value);
+
+        const auto runEnd = nextEvent < numEvents ? juce::jmin (endSample, events[static_cast<size_t> (nextEvent)].position) : endSample;
+        const auto offset = position - startSample;
+        const auto runLength = runEnd - position;
+
+        renderRamp (ramps[pitchBend], pitchRatios + offset, runLength, true);
+        renderRamp (ramps[pressure], pressures + offset, runLength, false);
+        renderRamp (ramps[slide], slides + offset, runLength, false);
+        position = runEnd;
+    }
+
+    if (nextEvent == numEvents)
+        numEvents = nextEvent = 0;
+}
+
+void NoteExpression::renderRamp (Ramp& ramp, float* output, int numSamples, bool isMultiplicative) noexcept
+{
+    const auto numSteps = juce::jmin (ramp.stepsRemaining, numSamples);
+
+    for (int i = 0; i < numSteps; ++i)
+    {
+        ramp.value = isMultiplicative ? ramp.value * ramp.step : ramp.value + ramp.step;
+        output[i] = ramp.value;
+    }
+
+    ramp.stepsRemaining -= numSteps;
+
+    if (numSteps > 0 && ramp.stepsRemaining == 0)
+    {
+        ramp.value = ramp.target;   // Lands exactly, whatever the rounding along the way.
+        output[numSteps - 1] = ramp.value;
+    }
+
+    std::fill (output + numSteps, output + numSamples, ramp.value);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+//==============================================================================
+// Per-note MPE expression for one voice: pitch bend, pressure and slide. The synth queues every change at its
+// sample within the block; render() turns the queue into per-sample control buffers, ramping each change over a
+// few milliseconds so 7-bit controller steps don't zipper. The voice's kernels read those buffers directly, so an
+// expression event neither retunes an oscillator nor splits the voice's block. Everything is fixed-size state, so
+// the voices' render-state snapshots can copy it without allocating.
+class NoteExpression final
+{
+public:
+    enum Dimension
+    {
+        pitchBend,   // Semitones; rendered as a frequency ratio.
+        pressure,    // 0 ... 1.
+        slide,       // 0 ... 1, neutral at neutralSlide (CC 74 at 64).
+        numDimensions
+    };
+
+    static constexpr int maxEventsPerBlock = 64;
+    static constexpr float neutralSlide = 0.5f;
+
+    // A note's starting values, taken without a ramp; clears anything queued.
+    void reset (float bendSemitones, float pressureValue, float slideValue) noexcept;
+
+    // In render-rate samples; 0 or 1 makes every change a step.
+    void setRampLength (int numSamples) noexcept   { rampLength = juce::jmax (1, numSamples); }
+
+    // Queues a change at samplePosition in the current block. Positions must not decrease within a block; with the
+    // queue full, the change overwrites the last one queued for the same dimension.
+    void addEvent (Dimension dimension, float value, int samplePosition) noexcept;
+
+    // Starts the ramps of anything a block left queued, i.e. a voice that wasn't rendered; call at each block start.
+    void beginBlock() noexcept;
+
+    // False when every dimension sits at its neutral value with nothing moving or queued, i.e. there is nothing to render.
+    bool isActive() const noexcept;
+
+    // Writes samples [startSample, startSample + numSamples) of the block: frequency ratios, pressures and slides.
+    void render (int startSample, int numSamples, float* pitchRatios, float* pressures, float* slides) noexcept;
+
+private:
+    struct Event
+    {
+        int position;
+        Dimension dimension;
+        float value;
+    };
+
+    struct Ramp
+    {
+        float value = 0.0f;
+        float target = 0.0f;
+        float step = 0.0f;   // Added per sample, or for the pitch ratio multiplied, so the ramp is even in semitones.
+        int stepsRemaining = 0;
+    };
+
+    void startRamp (Dimension dimension, float value) noexcept;
+    static void renderRamp (Ramp& ramp, float* output, int numSamples, bool isMultiplicative) noexcept;
+
+    std::array<Ramp, numDimensions> ramps {};
+    std::array<Event, maxEventsPerBlock> events {};
+    int numEvents = 0;
+    int nextEvent = 0;
+    int rampLength = 1;
+};
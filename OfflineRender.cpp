@@ -0,0 +1,627 @@
+#include "PluginProcessor.h"
+#include "ParameterIDs.h"
+
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <vector>
+
+// Headless render of AudioPluginAudioProcessor: Standard MIDI File + automation in, WAV out, as fast as the
+// machine allows. Prints the real-time factor and a per-block timing histogram, and optionally compares the
+// render against a reference WAV so optimised paths can be checked against the scalar one.
+//
+// --scenario replaces the MIDI file with one of the fixed note and automation scenarios below, so golden renders
+// need no input files: record one with --scenario sweep --out sweep-golden.wav, then check later builds with
+// --scenario sweep --out sweep.wav --reference sweep-golden.wav. Every render also reports its energy above
+// Nyquist/2, and --max-upper-band fails the render if that rises above the given level. --save-upper-band writes
+// the measured level to a text file; --upper-band-baseline reads one back and sets the limit --upper-band-margin
+// dB above it, so the limit follows what the golden render measured.
+//
+// Automation files are plain text, one point per line: "<seconds> <parameterID> <value>", e.g. "1.5 gain -6".
+// Values are in the parameter's own units; points are joined linearly and applied at block boundaries,
+// where the processor's own smoothing takes over. Lines starting with '#' are ignored.
+//
+// Exit codes: 0 = rendered (and passed the checks asked for), 1 = reference mismatch or too much upper-band energy,
+// 2 = usage or I/O error.
+
+namespace
+{
+struct Settings
+{
+    juce::File midiFile, outputFile, automationFile, referenceFile;
+    juce::String scenario;   // Built-in notes and automation instead of midiFile; see buildScenario().
+    double sampleRate = 48000.0;
+    int blockSize = 256;
+    double tailSeconds = 1.0;
+    int numWorkers = 0;
+    bool useVoiceBank = true;
+    bool useLiveEngine = false;   // Render through the real-time engine, e.g. to compare the voice bank with --scalar.
+    float tolerance = 0.0f;   // Largest absolute sample difference still counted as a match.
+    bool checkUpperBand = false;
+    double maxUpperBandDecibels = 0.0;   // Relative to the energy of the whole band.
+    juce::File saveUpperBandFile;
+};
+
+//==============================================================================
+class Automation
+{
+public:
+    bool load (const juce::File& file, juce::String& error)
+    {
+        juce::StringArray lines;
+        file.readLines (lines);
+
+        for (int lineNumber = 0; lineNumber < lines.size(); ++lineNumber)
+        {
+            const auto line = lines[lineNumber].trim();
+
+            if (line.isEmpty() || line.startsWithChar ('#'))
+                continue;
+
+            const auto tokens = juce::StringArray::fromTokens (line, " \t", {});
+
+            if (tokens.size() != 3)
+            {
+                error = file.getFileName() + ":" + juce::String (lineNumber + 1) + ": expected '<seconds> <parameterID> <value>'";
+                return false;
+            }
+
+            add (tokens[1], tokens[0].getDoubleValue(), tokens[2].getFloatValue());
+        }
+
+        for (auto& [parameterID, points] : curves)
+            std::stable_sort (points.begin(), points.end(), [] (const Point& a, const Point& b) { return a.time < b.time; });
+
+        return true;
+    }
+
+    // Points added after load() must come in time order.
+    void add (const juce::String& parameterID, double time, float value)
+    {
+        curves[parameterID].push_back ({ time, value });
+    }
+
+    // Sets every automated parameter to its curve's value at the given time.
+    void apply (juce::AudioProcessorValueTreeState& state, double time) const
+    {
+        for (const auto& [parameterID, points] : curves)
+            if (auto* parameter = state.getParameter (parameterID))
+                parameter->setValueNotifyingHost (parameter->convertTo0to1 (valueAt (points, time)));
+    }
+
+    juce::StringArray getUnknownParameters (juce::AudioProcessorValueTreeState& state) const
+    {
+        juce::StringArray unknown;
+
+        for (const auto& [parameterID, points] : curves)
+            if (state.getParameter (parameterID) == nullptr)
+                unknown.add (parameterID);
+
+        return unknown;
+    }
+
+private:
+    struct Point
+    {
+        double time;
+        float value;
+    };
+
+    static float valueAt (const std::vector<Point>& points, double time) noexcept
+    {
+        if (time <= points.front().time)
+            return points.front().value;
+
+        for (size_t i = 1; i < points.size(); ++i)
+        {
+            if (time < points[i].time)
+            {
+                const auto& a = points[i - 1];
+                const auto& b = points[i];
+                const auto proportion = static_cast<float> ((time - a.time) / (b.time - a.time));
+                return a.value + (proportion * (b.value - a.value));
+            }
+        }
+
+        return points.back().value;
+    }
+
+    std::map<juce::String, std::vector<Point>> curves;
+};
+
+//==============================================================================
+bool loadMidi (const juce::File& file, juce::MidiMessageSequence& sequence, juce::String& error)
+{
+    juce::FileInputStream stream (file);
+    juce::MidiFile midiFile;
+
+    if (! stream.openedOk() || ! midiFile.readFrom (stream))
+    {
+        error = "cannot read MIDI file " + file.getFullPathName();
+        return false;
+    }
+
+    midiFile.convertTimestampTicksToSeconds();
+
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+        sequence.addSequence (*midiFile.getTrack (track), 0.0);
+
+    sequence.sort();
+    return true;
+}
+
+//==============================================================================
+// The fixed scenarios, in the parameters' own units like automation files. The patch is the processor's default
+// apart from what each scenario automates.
+//   notes : single notes from C1 to C7 at different velocities, short and held, so releases overlap attacks.
+//   chords: overlapping four-note chords, enough to gather the voice bank's lanes.
+//   sweep : a held fifth under cutoff, pulse width and gain automation.
+//   high  : one held C7 with the filter open, where aliasing shows first.
+bool buildScenario (const juce::String& name, juce::MidiMessageSequence& sequence, Automation& automation)
+{
+    const auto addNote = [&sequence] (int note, float velocity, double start, double length)
+    {
+        sequence.addEvent (juce::MidiMessage::noteOn (1, note, velocity), start);
+        sequence.addEvent (juce::MidiMessage::noteOff (1, note), start + length);
+    };
+
+    if (name == "notes")
+    {
+        for (int i = 0; i < 7; ++i)
+            addNote (24 + (12 * i), 0.3f + (0.1f * static_cast<float> (i)), 0.4 * i, i % 2 == 0 ? 0.15 : 0.6);
+    }
+    else if (name == "chords")
+    {
+        static constexpr int chords[][4] { { 48, 52, 55, 59 }, { 45, 48, 52, 55 }, { 41, 45, 48, 52 }, { 43, 47, 50, 53 } };
+
+        for (int chord = 0; chord < 4; ++chord)
+            for (const auto note : chords[chord])
+                addNote (note, 0.8f, 0.6 * chord, 0.9);
+    }
+    else if (name == "sweep")
+    {
+        addNote (45, 0.8f, 0.0, 4.0);
+        addNote (52, 0.6f, 0.0, 4.0);
+
+        automation.add (filterCutoffParamID, 0.0, 0.0f);
+        automation.add (filterCutoffParamID, 2.0, 1.0f);
+        automation.add (filterCutoffParamID, 4.0, 0.2f);
+        automation.add (pulseWidthParamID, 0.0, 0.1f);
+        automation.add (pulseWidthParamID, 4.0, 0.9f);
+        automation.add (gainParamID, 0.0, -18.0f);
+        automation.add (gainParamID, 3.0, -6.0f);
+    }
+    else if (name == "high")
+    {
+        addNote (96, 0.8f, 0.0, 2.0);
+        automation.add (filterCutoffParamID, 0.0, 1.0f);
+    }
+    else
+    {
+        return false;
+    }
+
+    sequence.sort();
+    sequence.updateMatchedPairs();
+    return true;
+}
+
+//==============================================================================
+// Energy above half the Nyquist frequency against the whole band, over the mono sum of the render, in
+// Hann-windowed 4096-point frames. Up there these oscillators only have the last partials of high notes, so at
+// the same scenario and sample rate a rise between builds is aliasing folding back, or a filter letting more
+// through.
+class UpperBandEnergy
+{
+public:
+    void add (const juce::AudioBuffer<float>& buffer, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto sample = 0.0f;
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                sample += buffer.getSample (channel, i);
+
+            frame[static_cast<size_t> (numFramed++)] = sample;
+
+            if (numFramed == frameSize)
+                analyseFrame();
+        }
+    }
+
+    bool hasEnergy() const noexcept { return totalEnergy > 0.0; }
+    double getDecibels() const noexcept { return 10.0 * std::log10 (juce::jmax (1.0e-30, upperEnergy / totalEnergy)); }
+
+private:
+    void analyseFrame()
+    {
+        window.multiplyWithWindowingTable (frame.data(), static_cast<size_t> (frameSize));
+        fft.performFrequencyOnlyForwardTransform (frame.data());
+
+        for (int bin = 1; bin < frameSize / 2; ++bin)
+        {
+            const auto power = static_cast<double> (frame[static_cast<size_t> (bin)]) * frame[static_cast<size_t> (bin)];
+            totalEnergy += power;
+
+            if (bin >= frameSize / 4)
+                upperEnergy += power;
+        }
+
+        numFramed = 0;
+    }
+
+    static constexpr int frameOrder = 12;
+    static constexpr int frameSize = 1 << frameOrder;
+
+    juce::dsp::FFT fft { frameOrder };
+    juce::dsp::WindowingFunction<float> window { static_cast<size_t> (frameSize), juce::dsp::WindowingFunction<float>::hann };
+    std::vector<float> frame = std::vector<float> (static_cast<size_t> (2 * frameSize));   // The FFT needs twice the size.
+    int numFramed = 0;
+    double totalEnergy = 0.0, upperEnergy = 0.0;
+};
+
+//==============================================================================
+// Time of each processBlock() call as a fraction of the block's real-time budget.
+class BlockTimings
+{
+public:
+    void add (double seconds, double budgetSeconds) { loads.push_back (seconds / budgetSeconds); }
+
+    void print() const
+    {
+        if (loads.empty())
+            return;
+
+        auto sorted = loads;
+        std::sort (sorted.begin(), sorted.end());
+
+        const auto percentile = [&] (double p) { return sorted[static_cast<size_t> (p * static_cast<double> (sorted.size() - 1))]; };
+        std::printf ("Block load (%% of real-time budget): min %.2f  median %.2f  p99 %.2f  max %.2f\n",
+                     sorted.front() * 100.0, percentile (0.5) * 100.0, percentile (0.99) * 100.0, sorted.back() * 100.0);
+
+        static constexpr double bucketLimits[] { 0.01, 0.02, 0.05, 0.1, 0.25, 0.5, 1.0 };
+        size_t counts[std::size (bucketLimits) + 1] {};
+
+        for (const auto load : loads)
+            ++counts[static_cast<size_t> (std::upper_bound (std::begin (bucketLimits), std::end (bucketLimits), load) - std::begin (bucketLimits))];
+
+        for (size_t i = 0; i < std::size (counts); ++i)
+        {
+            const auto label = i < std::size (bucketLimits) ? "< " + juce::String (bucketLimits[i] * 100.0) + " %"
+                                                            : ">= " + juce::String (bucketLimits[i - 1] * 100.0) + " %";
+            const auto barLength = static_cast<int> (60.0 * static_cast<double> (counts[i]) / static_cast<double> (loads.size()));
+            std::printf ("  %8s %8zu  %s\n", label.toRawUTF8(), counts[i], juce::String::repeatedString ("#", barLength).toRawUTF8());
+        }
+    }
+
+private:
+    std::vector<double> loads;
+};
+
+//==============================================================================
+std::unique_ptr<juce::AudioFormatWriter> createWavWriter (const juce::File& file, double sampleRate, int numChannels)
+{
+    file.deleteFile();
+    auto stream = file.createOutputStream();
+
+    if (stream == nullptr)
+        return {};
+
+    // 32-bit float keeps the render bit-exact, so reference comparisons see exactly what the processor produced.
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate, static_cast<unsigned int> (numChannels),
+                                                                         32, {}, 0));
+    if (writer != nullptr)
+        stream.release();   // Now owned by the writer.
+
+    return writer;
+}
+
+// Reports the difference between the new render and the reference; returns true if within tolerance.
+bool compareWithReference (const Settings& settings, juce::String& error)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> rendered (formats.createReaderFor (settings.outputFile));
+    std::unique_ptr<juce::AudioFormatReader> reference (formats.createReaderFor (settings.referenceFile));
+
+    if (rendered == nullptr || reference == nullptr)
+    {
+        error = "cannot read " + (rendered == nullptr ? settings.outputFile : settings.referenceFile).getFullPathName();
+        return false;
+    }
+
+    if (rendered->numChannels != reference->numChannels || rendered->lengthInSamples != reference->lengthInSamples)
+    {
+        std::printf ("Reference mismatch: %u ch x %lld samples rendered, %u ch x %lld in the reference\n",
+                     rendered->numChannels, static_cast<long long> (rendered->lengthInSamples),
+                     reference->numChannels, static_cast<long long> (reference->lengthInSamples));
+        return false;
+    }
+
+    const auto numChannels = static_cast<int> (rendered->numChannels);
+    const auto length = rendered->lengthInSamples;
+    constexpr int chunkSize = 65536;
+    juce::AudioBuffer<float> a (numChannels, chunkSize), b (numChannels, chunkSize);
+
+    float maxDifference = 0.0f;
+    double sumOfSquares = 0.0;
+    juce::int64 firstDifference = -1;
+
+    for (juce::int64 start = 0; start < length; start += chunkSize)
+    {
+        const auto numSamples = static_cast<int> (juce::jmin<juce::int64> (chunkSize, length - start));
+        rendered->read (&a, 0, numSamples, start, true, true);
+        reference->read (&b, 0, numSamples, start, true, true);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* x = a.getReadPointer (channel);
+            const auto* y = b.getReadPointer (channel);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto difference = std::abs (x[i] - y[i]);
+
+                if (difference > 0.0f && (firstDifference < 0 || start + i < firstDifference))
+                    firstDifference = start + i;
+
+                maxDifference = juce::jmax (maxDifference, difference);
+                sumOfSquares += static_cast<double> (difference) * difference;
+            }
+        }
+    }
+
+    const auto rmsDifference = std::sqrt (sumOfSquares / static_cast<double> (juce::jmax<juce::int64> (1, length * numChannels)));
+    std::printf ("Reference: max |diff| %.3g (%.1f dBFS), rms diff %.1f dBFS",
+                 static_cast<double> (maxDifference), juce::Decibels::gainToDecibels (static_cast<double> (maxDifference), -300.0),
+                 juce::Decibels::gainToDecibels (rmsDifference, -300.0));
+
+    if (firstDifference >= 0)
+        std::printf (", first difference at sample %lld\n", static_cast<long long> (firstDifference));
+    else
+        std::printf (", bit-identical\n");
+
+    return maxDifference <= settings.tolerance;
+}
+
+//==============================================================================
+int render (const Settings& settings)
+{
+    juce::String error;
+    juce::MidiMessageSequence sequence;
+    Automation automation;
+
+    if (settings.scenario.isNotEmpty())
+    {
+        if (! buildScenario (settings.scenario, sequence, automation))
+        {
+            std::fprintf (stderr, "unknown scenario '%s'\n", settings.scenario.toRawUTF8());
+            return 2;
+        }
+    }
+    else if (! loadMidi (settings.midiFile, sequence, error))
+    {
+        std::fprintf (stderr, "%s\n", error.toRawUTF8());
+        return 2;
+    }
+
+    if (settings.automationFile != juce::File() && ! settings.automationFile.existsAsFile())
+    {
+        std::fprintf (stderr, "cannot find automation file %s\n", settings.automationFile.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    if (settings.automationFile != juce::File() && ! automation.load (settings.automationFile, error))
+    {
+        std::fprintf (stderr, "%s\n", error.toRawUTF8());
+        return 2;
+    }
+
+    AudioPluginAudioProcessor processor;
+    processor.setVoiceBankEnabled (settings.useVoiceBank);
+    processor.setNumRenderWorkers (settings.numWorkers);
+    processor.setNonRealtime (! settings.useLiveEngine);
+
+    for (const auto& parameterID : automation.getUnknownParameters (processor.getValueTreeState()))
+        std::fprintf (stderr, "warning: automation for unknown parameter '%s' is ignored\n", parameterID.toRawUTF8());
+
+    // Automation is applied before prepareToPlay() so the smoothers start at the curves' initial values.
+    automation.apply (processor.getValueTreeState(), 0.0);
+
+    constexpr int numChannels = 2;
+    processor.setPlayConfigDetails (0, numChannels, settings.sampleRate, settings.blockSize);
+    processor.prepareToPlay (settings.sampleRate, settings.blockSize);
+
+    auto writer = createWavWriter (settings.outputFile, settings.sampleRate, numChannels);
+
+    if (writer == nullptr)
+    {
+        std::fprintf (stderr, "cannot write %s\n", settings.outputFile.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    const auto endTime = (sequence.getNumEvents() > 0 ? sequence.getEndTime() : 0.0) + settings.tailSeconds;
+    const auto totalSamples = static_cast<juce::int64> (std::ceil (endTime * settings.sampleRate));
+
+    juce::AudioBuffer<float> buffer (numChannels, settings.blockSize);
+    juce::MidiBuffer midi;
+    BlockTimings timings;
+    UpperBandEnergy upperBand;
+    int nextEvent = 0;
+    double processingSeconds = 0.0;
+
+    for (juce::int64 position = 0; position < totalSamples; position += settings.blockSize)
+    {
+        const auto numSamples = static_cast<int> (juce::jmin<juce::int64> (settings.blockSize, totalSamples - position));
+        const auto blockStart = static_cast<double> (position) / settings.sampleRate;
+        const auto blockEnd = static_cast<double> (position + numSamples) / settings.sampleRate;
+
+        midi.clear();
+
+        for (; nextEvent < sequence.getNumEvents(); ++nextEvent)
+        {
+            const auto& message = sequence.getEventPointer (nextEvent)->message;
+
+            if (message.getTimeStamp() >= blockEnd)
+                break;
+
+            if (! message.isMetaEvent())
+            {
+                const auto offset = static_cast<int> ((message.getTimeStamp() - blockStart) * settings.sampleRate);
+                midi.addEvent (message, juce::jlimit (0, numSamples - 1, offset));
+            }
+        }
+
+        automation.apply (processor.getValueTreeState(), blockStart);
+        buffer.setSize (numChannels, numSamples, false, false, true);
+
+        const auto started = std::chrono::steady_clock::now();
+        processor.processBlock (buffer, midi);
+        const auto seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - started).count();
+
+        processingSeconds += seconds;
+        timings.add (seconds, numSamples / settings.sampleRate);
+        writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+        upperBand.add (buffer, numSamples);
+    }
+
+    processor.releaseResources();
+    writer.reset();   // Flushes and closes the file before it is read back for comparison.
+
+    const auto audioSeconds = static_cast<double> (totalSamples) / settings.sampleRate;
+    std::printf ("Rendered %.2f s at %.0f Hz in %d-sample blocks: processing took %.3f s, real-time factor %.1fx\n",
+                 audioSeconds, settings.sampleRate, settings.blockSize, processingSeconds,
+                 processingSeconds > 0.0 ? audioSeconds / processingSeconds : 0.0);
+    timings.print();
+
+    auto passed = true;
+
+    if (upperBand.hasEnergy())
+    {
+        const auto decibels = upperBand.getDecibels();
+        std::printf ("Energy above Nyquist/2: %.1f dB of the total", decibels);
+
+        if (settings.checkUpperBand)
+        {
+            passed = decibels <= settings.maxUpperBandDecibels;
+            std::printf (" (limit %.1f dB%s)", settings.maxUpperBandDecibels, passed ? "" : ", exceeded");
+        }
+
+        std::printf ("\n");
+    }
+
+    if (settings.saveUpperBandFile != juce::File()
+        && ! (upperBand.hasEnergy() && settings.saveUpperBandFile.replaceWithText (juce::String (upperBand.getDecibels(), 2) + "\n")))
+    {
+        std::fprintf (stderr, "cannot write upper-band level %s\n", settings.saveUpperBandFile.getFullPathName().toRawUTF8());
+        return 2;
+    }
+
+    if (settings.referenceFile == juce::File())
+        return passed ? 0 : 1;
+
+    const auto matched = compareWithReference (settings, error);
+
+    if (error.isNotEmpty())
+    {
+        std::fprintf (stderr, "%s\n", error.toRawUTF8());
+        return 2;
+    }
+
+    return matched && passed ? 0 : 1;
+}
+
+juce::File fileOption (const juce::ArgumentList& args, const juce::String& option)
+{
+    return args.containsOption (option) ? args.getFileForOption (option) : juce::File();
+}
+
+// A level written by --save-upper-band: one number, in dB against the whole band.
+bool readUpperBandLevel (const juce::File& file, double& decibels)
+{
+    const auto text = file.loadFileAsString().trim();
+
+    if (! file.existsAsFile() || ! text.containsAnyOf ("0123456789"))
+        return false;
+
+    decibels = text.getDoubleValue();
+    return true;
+}
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList args (argc, argv);
+
+    const auto hasInput = args.containsOption ("--midi") || args.containsOption ("--scenario");
+
+    if (args.containsOption ("--help|-h") || ! hasInput || ! args.containsOption ("--out"))
+    {
+        std::printf ("Usage: %s (--midi song.mid | --scenario notes|chords|sweep|high) --out render.wav\n"
+                     "       [--automation curves.txt] [--reference golden.wav] [--tolerance 0] [--max-upper-band -40]\n"
+                     "       [--save-upper-band level.txt] [--upper-band-baseline level.txt] [--upper-band-margin 3]\n"
+                     "       [--rate 48000] [--block-size 256] [--tail 1.0] [--workers W] [--scalar] [--live-engine]\n",
+                     args.executableName.toRawUTF8());
+        return args.containsOption ("--help|-h") ? 0 : 2;
+    }
+
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;   // The processor's parameter state needs a message manager.
+
+    Settings settings;
+    settings.midiFile = fileOption (args, "--midi");
+    settings.scenario = args.getValueForOption ("--scenario");
+    settings.outputFile = args.getFileForOption ("--out");
+    settings.automationFile = fileOption (args, "--automation");
+    settings.referenceFile = fileOption (args, "--reference");
+    settings.saveUpperBandFile = fileOption (args, "--save-upper-band");
+    settings.useVoiceBank = ! args.containsOption ("--scalar");
+    settings.useLiveEngine = args.containsOption ("--live-engine");
+
+    if (args.containsOption ("--rate"))
+        settings.sampleRate = juce::jmax (8000.0, args.getValueForOption ("--rate").getDoubleValue());
+
+    if (args.containsOption ("--block-size"))
+        settings.blockSize = juce::jlimit (1, 65536, args.getValueForOption ("--block-size").getIntValue());
+
+    if (args.containsOption ("--tail"))
+        settings.tailSeconds = juce::jmax (0.0, args.getValueForOption ("--tail").getDoubleValue());
+
+    if (args.containsOption ("--workers"))
+        settings.numWorkers = juce::jmax (0, args.getValueForOption ("--workers").getIntValue());
+
+    if (args.containsOption ("--tolerance"))
+        settings.tolerance = juce::jmax (0.0f, args.getValueForOption ("--tolerance").getFloatValue());
+
+    if (args.containsOption ("--max-upper-band"))
+    {
+        settings.checkUpperBand = true;
+        settings.maxUpperBandDecibels = args.getValueForOption ("--max-upper-band").getDoubleValue();
+    }
+
+    // With both, the tighter of the two limits applies.
+    if (args.containsOption ("--upper-band-baseline"))
+    {
+        const auto baselineFile = args.getFileForOption ("--upper-band-baseline");
+        const auto margin = args.containsOption ("--upper-band-margin") ? args.getValueForOption ("--upper-band-margin").getDoubleValue() : 3.0;
+        auto measured = 0.0;
+
+        if (! readUpperBandLevel (baselineFile, measured))
+        {
+            std::fprintf (stderr, "cannot read upper-band baseline %s\n", baselineFile.getFullPathName().toRawUTF8());
+            return 2;
+        }
+
+        const auto limit = measured + juce::jmax (0.0, margin);
+        settings.maxUpperBandDecibels = settings.checkUpperBand ? juce::jmin (settings.maxUpperBandDecibels, limit) : limit;
+        settings.checkUpperBand = true;
+    }
+
+    return render (settings);
+}
@@ -0,0 +1,324 @@
+#include "Oscillators.h"
+#include "FastSine.h"
+
+namespace
+{
+// One feedback-FM saw step, excluding the phase advance; shared by the per-sample and block entry points.
+// exactSine selects std::sin over FastSine; only the float fast kernel has to match the voice bank bit for bit.
+template <typename SampleType, bool exactSine>
+inline SampleType sawSample (SampleType phase, SampleType& osc, SampleType& previousInput,
+                             SampleType beta, SampleType dc, SampleType inverseNorm) noexcept
+{
+    const auto feedbackPhase = phase + (osc * beta);
+    SampleType input;
+
+    if constexpr (exactSine)
+        input = std::sin (juce::MathConstants<SampleType>::twoPi * feedbackPhase);
+    else
+        input = FastSine::sinTwoPi (feedbackPhase);
+
+    osc = SampleType (0.5) * (osc + input);
+
+    const auto filtered = (SampleType (AntiAliasedSawOscillator::hfCompA0) * osc)
+                        + (SampleType (AntiAliasedSawOscillator::hfCompA1) * previousInput);
+    previousInput = osc;
+
+    return (filtered - dc) * inverseNorm;
+}
+
+// The saw core's per-frequency terms, for setFrequency() and the pitch-modulated kernels alike.
+struct SawTerms
+{
+    float w, beta, dc, inverseNorm;
+};
+
+inline SawTerms sawTermsFor (float normalisedFrequency) noexcept
+{
+    const auto w = juce::jlimit (0.0f, 0.49f, normalisedFrequency);
+    const auto diff = 0.5f - w;
+    return { w, 13.0f * diff * diff * diff * diff, 0.376f - (0.752f * w),
+             1.0f / juce::jmax (AntiAliasedSawOscillator::minNorm, 1.0f - (2.0f * w)) };
+}
+
+// Phases stay below 1 + 0.99, so a single select replaces the wrap loop and keeps the kernels branch-free.
+template <typename SampleType>
+inline SampleType wrapPhase (SampleType phase) noexcept
+{
+    return phase >= SampleType (1) ? phase - SampleType (1) : phase;
+}
+}
+
+// Feedback-FM + polynomial compensation keeps the saw harmonics controlled when the frequency changes.
+void AntiAliasedSawOscillator::setFrequency (float newFrequency, double newSampleRate) noexcept
+{
+    if (newSampleRate <= 0.0)
+        return;
+
+    const auto terms = sawTermsFor (static_cast<float> (newFrequency / static_cast<float> (newSampleRate)));
+    w = terms.w;
+    beta = terms.beta;
+    dc = terms.dc;
+    inverseNorm = terms.inverseNorm;
+}
+
+// Generate one anti-aliased saw sample that forms the building block for the pulse oscillator edges.
+float AntiAliasedSawOscillator::getNextSample() noexcept
+{
+    float output;
+    processBlock (&output, 1);
+    return output;
+}
+
+// Block version of getNextSample(): state and per-frequency constants are loaded into locals once per call.
+void AntiAliasedSawOscillator::processBlock (float* output, int numSamples) noexcept
+{
+    auto localPhase = static_cast<float> (phase);
+    auto localOsc = static_cast<float> (osc);
+    auto localPrevious = static_cast<float> (previousInput);
+    const auto localW = w;
+    const auto localBeta = beta;
+    const auto localDc = dc;
+    const auto localInverseNorm = inverseNorm;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        output[i] = sawSample<float, false> (localPhase, localOsc, localPrevious, localBeta, localDc, localInverseNorm);
+        localPhase = wrapPhase (localPhase + localW);
+    }
+
+    phase = localPhase;
+    osc = localOsc;
+    previousInput = localPrevious;
+}
+
+void AntiAliasedSawOscillator::reset() noexcept
+{
+    phase = 0.0;
+    osc = 0.0;
+    previousInput = 0.0;
+}
+
+// Both edges share the incoming frequency so we can reuse the saw core for the pulse waveform.
+void AntiAliasedPulseOscillator::setFrequency (float newFrequency, double newSampleRate) noexcept
+{
+    leadingEdge.setFrequency (newFrequency, newSampleRate);
+    trailingEdge.setFrequency (newFrequency, newSampleRate);
+}
+
+// Pulse width modulation is clamped to avoid degeneracies but still satisfies the UI requirement.
+void AntiAliasedPulseOscillator::setPulseWidth (float newPulseWidth) noexcept
+{
+    pulseWidth = juce::jlimit (0.01f, 0.99f, newPulseWidth);
+}
+
+// Compose two phase-shifted saw waves to obtain the anti-aliased pulse output.
+float AntiAliasedPulseOscillator::getNextSample() noexcept
+{
+    float output;
+    processBlock (&output, 1);
+    return output;
+}
+
+// Block version of getNextSample(); produces the same samples but keeps both edges in registers across the loop.
+void AntiAliasedPulseOscillator::processBlock (float* output, int numSamples) noexcept
+{
+    render<float, false, false, false> (output, nullptr, nullptr, numSamples);
+}
+
+// Smoothed pulse width: each sample uses its own width, clamped like setPulseWidth(); the last one is kept.
+void AntiAliasedPulseOscillator::processBlock (float* output, const float* pulseWidths, int numSamples) noexcept
+{
+    render<float, true, false, false> (output, pulseWidths, nullptr, numSamples);
+
+    if (numSamples > 0)
+        setPulseWidth (pulseWidths[numSamples - 1]);
+}
+
+// The set frequency itself stays as it was; only this block's samples are bent.
+void AntiAliasedPulseOscillator::processBlock (float* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept
+{
+    render<float, true, false, true> (output, pulseWidths, pitchRatios, numSamples);
+
+    if (numSamples > 0)
+        setPulseWidth (pulseWidths[numSamples - 1]);
+}
+
+void AntiAliasedPulseOscillator::processBlockPrecise (double* output, const float* pulseWidths, int numSamples) noexcept
+{
+    if (pulseWidths == nullptr)
+    {
+        render<double, false, true, false> (output, nullptr, nullptr, numSamples);
+        return;
+    }
+
+    render<double, true, true, false> (output, pulseWidths, nullptr, numSamples);
+
+    if (numSamples > 0)
+        setPulseWidth (pulseWidths[numSamples - 1]);
+}
+
+void AntiAliasedPulseOscillator::processBlockPrecise (double* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept
+{
+    if (pulseWidths == nullptr)
+    {
+        render<double, false, true, true> (output, nullptr, pitchRatios, numSamples);
+        return;
+    }
+
+    render<double, true, true, true> (output, pulseWidths, pitchRatios, numSamples);
+
+    if (numSamples > 0)
+        setPulseWidth (pulseWidths[numSamples - 1]);
+}
+
+// Both edges always share one frequency, so a pitch ramp works out one set of terms per sample for the two.
+template <typename SampleType, bool hasWidthRamp, bool exactSine, bool hasPitchRamp>
+void AntiAliasedPulseOscillator::render (SampleType* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept
+{
+    auto& l = leadingEdge;
+    auto& t = trailingEdge;
+
+    auto leadingPhase = static_cast<SampleType> (l.phase);
+    auto leadingOsc = static_cast<SampleType> (l.osc);
+    auto leadingPrevious = static_cast<SampleType> (l.previousInput);
+    auto trailingPhase = static_cast<SampleType> (t.phase);
+    auto trailingOsc = static_cast<SampleType> (t.osc);
+    auto trailingPrevious = static_cast<SampleType> (t.previousInput);
+
+    // Hoisted so the compiler need not assume the output pointer aliases them.
+    const auto constantWidth = SampleType (pulseWidth);
+    auto leadingW = SampleType (l.w), leadingBeta = SampleType (l.beta), leadingDc = SampleType (l.dc), leadingInverseNorm = SampleType (l.inverseNorm);
+    auto trailingW = SampleType (t.w), trailingBeta = SampleType (t.beta), trailingDc = SampleType (t.dc), trailingInverseNorm = SampleType (t.inverseNorm);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if constexpr (hasPitchRamp)
+        {
+            const auto terms = sawTermsFor (l.w * pitchRatios[i]);
+            leadingW = trailingW = SampleType (terms.w);
+            leadingBeta = trailingBeta = SampleType (terms.beta);
+            leadingDc = trailingDc = SampleType (terms.dc);
+            leadingInverseNorm = trailingInverseNorm = SampleType (terms.inverseNorm);
+        }
+
+        const auto leading = sawSample<SampleType, exactSine> (leadingPhase, leadingOsc, leadingPrevious, leadingBeta, leadingDc, leadingInverseNorm);
+        leadingPhase = wrapPhase (leadingPhase + leadingW);
+
+        SampleType width;
+
+        if constexpr (hasWidthRamp)
+            width = SampleType (juce::jlimit (0.01f, 0.99f, pulseWidths[i]));
+        else
+            width = constantWidth;
+
+        const auto shiftedPhase = wrapPhase (leadingPhase + width);
+        const auto trailing = sawSample<SampleType, exactSine> (shiftedPhase, trailingOsc, trailingPrevious, trailingBeta, trailingDc, trailingInverseNorm);
+        trailingPhase = wrapPhase (shiftedPhase + trailingW);
+
+        output[i] = juce::jmin (SampleType (1), juce::jmax (SampleType (-1), leading - trailing));
+    }
+
+    l.phase = leadingPhase;
+    l.osc = leadingOsc;
+    l.previousInput = leadingPrevious;
+    t.phase = trailingPhase;
+    t.osc = trailingOsc;
+    t.previousInput = trailingPrevious;
+}
+
+void AntiAliasedPulseOscillator::reset() noexcept
+{
+    leadingEdge.reset();
+    trailingEdge.reset();
+}
+
+//==============================================================================
+// IIRCoefficients already stores b0/b1/b2/a1/a2 normalised by a0.
+void LowPassBiquad::setCoefficients (const juce::IIRCoefficients& newCoefficients) noexcept
+{
+    b0 = newCoefficients.coefficients[0];
+    b1 = newCoefficients.coefficients[1];
+    b2 = newCoefficients.coefficients[2];
+    a1 = newCoefficients.coefficients[3];
+    a2 = newCoefficients.coefficients[4];
+}
+
+void LowPassBiquad::processBlock (float* samples, int numSamples) noexcept
+{
+    render (samples, numSamples);
+}
+
+void LowPassBiquad::processBlock (double* samples, int numSamples) noexcept
+{
+    render (samples, numSamples);
+}
+
+template <typename SampleType>
+void LowPassBiquad::render (SampleType* samples, int numSamples) noexcept
+{
+    auto localZ1 = static_cast<SampleType> (z1);
+    auto localZ2 = static_cast<SampleType> (z2);
+
+    for (int i = 0; i < numSamples; ++i)
+        samples[i] = tick (samples[i], localZ1, localZ2);
+
+    z1 = localZ1;
+    z2 = localZ2;
+}
+
+void LowPassBiquad::reset() noexcept
+{
+    z1 = 0.0;
+    z2 = 0.0;
+}
+
+//==============================================================================
+void LowPassSvf::processBlock (float* samples, int numSamples) noexcept
+{
+    render<float, false> (samples, nullptr, numSamples);
+}
+
+void LowPassSvf::processBlock (float* samples, const Coefficients* coefficientRamp, int numSamples) noexcept
+{
+    render<float, true> (samples, coefficientRamp, numSamples);
+}
+
+void LowPassSvf::processBlock (double* samples, int numSamples) noexcept
+{
+    render<double, false> (samples, nullptr, numSamples);
+}
+
+void LowPassSvf::processBlock (double* samples, const Coefficients* coefficientRamp, int numSamples) noexcept
+{
+    render<double, true> (samples, coefficientRamp, numSamples);
+}
+
+// A ramp keeps its last set, so a following constant block carries on where the sweep ended.
+template <typename SampleType, bool hasCoefficientRamp>
+void LowPassSvf::render (SampleType* samples, const Coefficients* coefficientRamp, int numSamples) noexcept
+{
+    auto localIc1 = static_cast<SampleType> (ic1eq);
+    auto localIc2 = static_cast<SampleType> (ic2eq);
+    const auto c = coefficients;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if constexpr (hasCoefficientRamp)
+            samples[i] = tick (samples[i], localIc1, localIc2, coefficientRamp[i]);
+        else
+            samples[i] = tick (samples[i], localIc1, localIc2, c);
+    }
+
+    ic1eq = localIc1;
+    ic2eq = localIc2;
+
+    if constexpr (hasCoefficientRamp)
+        if (numSamples > 0)
+            coefficients = coefficientRamp[numSamples - 1];
+}
+
+void LowPassSvf::reset() noexcept
+{
+    ic1eq = 0.0;
+    ic2eq = 0.0;
+}
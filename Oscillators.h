@@ -0,0 +1,178 @@
+#pragma once
+
+#include "PulseKernels.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// These custom oscillator types implement the anti-aliased saw/pulse algorithms required by the assignment.
+//
+// Running state is kept in double. The float kernels round it to float on entry, so a voice that only ever runs
+// them reproduces the old single-precision behaviour exactly. The precise kernels, used by the processor's
+// render engine, compute in double with std::sin from one block to the next.
+
+class AntiAliasedVoice;
+class PulseVoiceBank;
+class UnisonOscillator;
+
+//==============================================================================
+class AntiAliasedSawOscillator final
+{
+public:
+    // Shared by the scalar oscillators and the SIMD voice bank so both paths run identical maths.
+    static constexpr float hfCompA0 = SawCoreConstants::hfCompA0;
+    static constexpr float hfCompA1 = SawCoreConstants::hfCompA1;
+    static constexpr float minNorm = 0.001f;
+
+    void setFrequency (float newFrequency, double newSampleRate) noexcept;
+    float getNextSample() noexcept;
+    void processBlock (float* output, int numSamples) noexcept;
+    void reset() noexcept;
+
+private:
+    friend class AntiAliasedPulseOscillator;
+    friend class PulseVoiceBank;
+    friend class UnisonOscillator;
+    double phase = 0.0;
+    double osc = 0.0;
+    double previousInput = 0.0;
+    float w = 0.0f;
+    float beta = 0.0f;
+    float dc = 0.376f;          // Output offset and reciprocal normalisation only depend on w,
+    float inverseNorm = 1.0f;   // so setFrequency() caches them instead of recomputing per sample.
+};
+
+class AntiAliasedPulseOscillator final
+{
+public:
+    void setFrequency (float newFrequency, double newSampleRate) noexcept;
+    void setPulseWidth (float newPulseWidth) noexcept;
+    float getNextSample() noexcept;
+    void processBlock (float* output, int numSamples) noexcept;   // Same samples as numSamples calls to getNextSample().
+    void processBlock (float* output, const float* pulseWidths, int numSamples) noexcept;   // Per-sample pulse width.
+    void reset() noexcept;
+
+    // Per-sample pulse width and multiplier of the set frequency, for per-note pitch bend. The frequency-dependent
+    // terms are worked out every sample, so this costs a division per sample more than the kernels above.
+    void processBlock (float* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept;
+
+    // Render-engine kernel: double arithmetic and std::sin throughout. pulseWidths may be null.
+    void processBlockPrecise (double* output, const float* pulseWidths, int numSamples) noexcept;
+    void processBlockPrecise (double* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept;
+
+private:
+    friend class PulseVoiceBank;
+    friend class UnisonOscillator;
+
+    template <typename SampleType, bool hasWidthRamp, bool exactSine, bool hasPitchRamp>
+    void render (SampleType* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept;
+
+    AntiAliasedSawOscillator leadingEdge;
+    AntiAliasedSawOscillator trailingEdge;
+    float pulseWidth = 0.5f;
+};
+
+//==============================================================================
+// Transposed direct form II biquad with the same arithmetic as juce::IIRFilter, but lock-free and with
+// visible state so the voice bank can gather it into SIMD lanes.
+class LowPassBiquad final
+{
+public:
+    void setCoefficients (const juce::IIRCoefficients& newCoefficients) noexcept;
+    void reset() noexcept;
+
+    float processSample (float input) noexcept
+    {
+        auto s1 = static_cast<float> (z1), s2 = static_cast<float> (z2);
+        const auto output = tick (input, s1, s2);
+        z1 = s1;
+        z2 = s2;
+        return output;
+    }
+
+    void processBlock (float* samples, int numSamples) noexcept;    // In place.
+    void processBlock (double* samples, int numSamples) noexcept;   // In place, double state throughout.
+
+private:
+    friend class AntiAliasedVoice;   // Its fused kernels run tick() inside their own loop.
+    friend class PulseVoiceBank;
+
+    template <typename SampleType>
+    SampleType tick (SampleType input, SampleType& s1, SampleType& s2) const noexcept
+    {
+        const auto output = (SampleType (b0) * input) + s1;
+        s1 = ((SampleType (b1) * input) - (SampleType (a1) * output)) + s2;
+        s2 = (SampleType (b2) * input) - (SampleType (a2) * output);
+        return output;
+    }
+
+    template <typename SampleType>
+    void render (SampleType* samples, int numSamples) noexcept;
+
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    double z1 = 0.0, z2 = 0.0;
+};
+
+//==============================================================================
+// Topology-preserving-transform state-variable low-pass (Zavalishin / Simper). With k = sqrt(2) it has the same
+// response as the bilinear Butterworth above, but its coefficients follow from g = tan (pi * fc / fs) with no
+// trig or division per voice and stay well behaved when changed every sample, so cutoff sweeps need no zipper
+// handling. Coefficients are precomputed by the caller (see SmoothedParameters) and shared between voices.
+class LowPassSvf final
+{
+public:
+    using Coefficients = SvfCoefficients;   // See PulseKernels.h.
+
+    void setCoefficients (const Coefficients& newCoefficients) noexcept { coefficients = newCoefficients; }
+    void reset() noexcept;
+
+    float processSample (float input) noexcept
+    {
+        auto ic1 = static_cast<float> (ic1eq), ic2 = static_cast<float> (ic2eq);
+        const auto output = tick (input, ic1, ic2, coefficients);
+        ic1eq = ic1;
+        ic2eq = ic2;
+        return output;
+    }
+
+    void processBlock (float* samples, int numSamples) noexcept;   // In place.
+    void processBlock (float* samples, const Coefficients* coefficientRamp, int numSamples) noexcept;   // One set per sample.
+
+    // Double state throughout; the coefficients stay float.
+    void processBlock (double* samples, int numSamples) noexcept;
+    void processBlock (double* samples, const Coefficients* coefficientRamp, int numSamples) noexcept;
+
+private:
+    friend class AntiAliasedVoice;
+    friend class PulseVoiceBank;
+
+    template <typename SampleType>
+    static SampleType tick (SampleType input, SampleType& ic1, SampleType& ic2, const Coefficients& c) noexcept
+    {
+        const auto v3 = input - ic2;
+        const auto v1 = (SampleType (c.a1) * ic1) + (SampleType (c.a2) * v3);
+        const auto v2 = (ic2 + (SampleType (c.a2) * ic1)) + (SampleType (c.a3) * v3);
+        ic1 = (SampleType (2) * v1) - ic1;
+        ic2 = (SampleType (2) * v2) - ic2;
+        return v2;
+    }
+
+    template <typename SampleType, bool hasCoefficientRamp>
+    void render (SampleType* samples, const Coefficients* coefficientRamp, int numSamples) noexcept;
+
+    Coefficients coefficients;
+    double ic1eq = 0.0, ic2eq = 0.0;
+};
+
+// Which low-pass the voices run; selected by the Filter Type parameter.
+enum class VoiceFilterType
+{
+    biquad,
+    svf
+};
+
+// Which pulse oscillator the voices run; selected by the Oscillator parameter. See WavetablePulseOscillator.
+enum class OscillatorEngine
+{
+    feedbackFm,
+    wavetable
+};
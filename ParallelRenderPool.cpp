@@ -0,0 +1,150 @@
+#include "ParallelRenderPool.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+// Tells the core we are busy-waiting, so the sibling hyper-thread and the memory bus are not starved.
+inline void spinPause() noexcept
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif defined (__aarch64__) || defined (__arm__)
+    __asm__ __volatile__ ("yield");
+   #endif
+}
+
+juce::uint32 generationOf (juce::uint64 state) noexcept
+{
+    return static_cast<juce::uint32> (state >> 32);
+}
+}
+
+//==============================================================================
+class ParallelRenderPool::Worker final : public juce::Thread
+{
+public:
+    explicit Worker (ParallelRenderPool& ownerPool)
+        : juce::Thread ("DPlugin render worker"), pool (ownerPool)
+    {
+    }
+
+    void run() override
+    {
+        auto lastGeneration = generationOf (pool.jobState.load (std::memory_order_acquire));
+        auto lastJobTime = juce::Time::getMillisecondCounterHiRes();
+
+        while (! threadShouldExit())
+        {
+            const auto state = pool.jobState.load (std::memory_order_acquire);
+
+            if (generationOf (state) != lastGeneration)
+            {
+                lastGeneration = generationOf (state);
+                pool.helpWith (state);
+                lastJobTime = juce::Time::getMillisecondCounterHiRes();
+                continue;
+            }
+
+            // Stay hot between audio callbacks, but stop burning a core once the host stops calling us.
+            if (juce::Time::getMillisecondCounterHiRes() - lastJobTime < idleMillisecondsBeforeSleeping)
+            {
+                for (int i = 0; i < 64; ++i)
+                    spinPause();
+            }
+            else
+            {
+                juce::Thread::sleep (1);
+            }
+        }
+    }
+
+private:
+    static constexpr double idleMillisecondsBeforeSleeping = 50.0;
+
+    ParallelRenderPool& pool;
+};
+
+//==============================================================================
+ParallelRenderPool::ParallelRenderPool() = default;
+
+ParallelRenderPool::~ParallelRenderPool()
+{
+    setNumWorkers (0);
+}
+
+void ParallelRenderPool::setNumWorkers (int newNumWorkers)
+{
+    newNumWorkers = juce::jmax (0, newNumWorkers);
+
+    if (newNumWorkers == getNumWorkers())
+        return;
+
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto& worker : workers)
+        worker->stopThread (1000);
+
+    workers.clear();
+
+    for (int i = 0; i < newNumWorkers; ++i)
+    {
+        workers.push_back (std::make_unique<Worker> (*this));
+        workers.back()->startThread (juce::Thread::Priority::highest);
+    }
+}
+
+void ParallelRenderPool::run (TaskFunction task, void* context, int numTasks) noexcept
+{
+    if (numTasks <= 0)
+        return;
+
+    if (workers.empty() || numTasks == 1 || numTasks > maxTasks)
+    {
+        for (int i = 0; i < numTasks; ++i)
+            task (context, i);
+
+        return;
+    }
+
+    currentTask = task;
+    currentContext = context;
+    tasksCompleted.store (0, std::memory_order_relaxed);
+
+    const auto state = pack (++generation, numTasks, 0);
+    jobState.store (state, std::memory_order_release);
+
+    helpWith (state);
+
+    while (tasksCompleted.load (std::memory_order_acquire) < numTasks)
+        spinPause();
+}
+
+bool ParallelRenderPool::helpWith (juce::uint64 state) noexcept
+{
+    const auto jobGeneration = generationOf (state);
+    auto didWork = false;
+
+    while (generationOf (state) == jobGeneration)
+    {
+        const auto numTasks = static_cast<int> ((state >> 16) & indexMask);
+        const auto nextTask = static_cast<int> (state & indexMask);
+
+        if (nextTask >= numTasks)
+            break;
+
+        // On failure 'state' is reloaded and the generation re-checked, so a claim can never leak into a newer job.
+        if (jobState.compare_exchange_weak (state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            currentTask (currentContext, nextTask);
+            tasksCompleted.fetch_add (1, std::memory_order_release);
+            didWork = true;
+            state = jobState.load (std::memory_order_acquire);
+        }
+    }
+
+    return didWork;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Fixed set of worker threads that help the audio thread run a parallel-for over independent tasks.
+//
+// Hand-off is lock-free: run() publishes a job by storing one packed atomic word (generation, task count,
+// next task), every thread claims tasks with compare-and-swap, and completions are counted on a second atomic.
+// The calling thread claims tasks too, so a job always finishes even if no worker is awake; it only ever
+// spins on tasks another thread has already started. Workers spin briefly after each job and back off to
+// sleeping when the audio thread goes quiet. Nothing on the run() path allocates or takes a mutex.
+class ParallelRenderPool final
+{
+public:
+    using TaskFunction = void (*) (void* context, int taskIndex) noexcept;
+
+    ParallelRenderPool();
+    ~ParallelRenderPool();
+
+    // Starts or stops workers; call from the message thread while audio is not processing (e.g. prepareToPlay).
+    void setNumWorkers (int newNumWorkers);
+    int getNumWorkers() const noexcept { return static_cast<int> (workers.size()); }
+
+    // Runs task (context, i) for every i in [0, numTasks) and returns once all of them have finished.
+    void run (TaskFunction task, void* context, int numTasks) noexcept;
+
+private:
+    class Worker;
+
+    static constexpr juce::uint64 indexMask = 0xffff;
+    static constexpr int maxTasks = static_cast<int> (indexMask);
+
+    static juce::uint64 pack (juce::uint32 generation, int numTasks, int nextTask) noexcept
+    {
+        return (static_cast<juce::uint64> (generation) << 32) | (static_cast<juce::uint64> (numTasks) << 16) | static_cast<juce::uint64> (nextTask);
+    }
+
+    // Claims and runs tasks of the job published as 'state' until none are left; returns false if it got none.
+    bool helpWith (juce::uint64 state) noexcept;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    alignas (64) std::atomic<juce::uint64> jobState { 0 };
+    alignas (64) std::atomic<int> tasksCompleted { 0 };
+    TaskFunction currentTask = nullptr;   // Written before jobState is published, read after it is observed.
+    void* currentContext = nullptr;
+    juce::uint32 generation = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParallelRenderPool)
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// APVTS parameter IDs shared by the processor and the voices.
+// Keeping them in one place makes it easy to cross-wire the DSP code and parameter layout without string duplication.
+inline constexpr auto gainParamID = "gain";
+inline constexpr auto pulseWidthParamID = "pulseWidth";
+inline constexpr auto filterCutoffParamID = "filterCutoff";
+inline constexpr auto polyphonyParamID = "polyphony";
+inline constexpr auto filterTypeParamID = "filterType";
+inline constexpr auto qualityParamID = "quality";
+inline constexpr auto attackParamID = "attack";
+inline constexpr auto decayParamID = "decay";
+inline constexpr auto sustainParamID = "sustain";
+inline constexpr auto releaseParamID = "release";
+inline constexpr auto voiceStealingParamID = "voiceStealing";
+inline constexpr auto unisonVoicesParamID = "unisonVoices";
+inline constexpr auto unisonDetuneParamID = "unisonDetune";
+inline constexpr auto unisonSpreadParamID = "unisonSpread";
+inline constexpr auto oscillatorEngineParamID = "oscillatorEngine";
+inline constexpr auto mpeBendRangeParamID = "mpeBendRange";
+inline constexpr auto multiTimbralParamID = "multiTimbral";
@@ -4,9 +4,12 @@
 //==============================================================================
 AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAudioProcessor& p)
     : AudioProcessorEditor (&p), processorRef (p),
-      midiKeyboard (processorRef.getKeyboardState(), juce::MidiKeyboardComponent::horizontalKeyboard)
+      midiKeyboard (processorRef.getKeyboardState(), juce::MidiKeyboardComponent::horizontalKeyboard),
+      analyser (processorRef.getAnalyserTap()),
+      vBlankAttachment (this, [this] { refresh(); })
 {
-    setSize (360, 220); // Compact footprint to fit three faders plus the built-in keyboard.
+    setOpaque (true);   // The cached background covers every pixel, so nothing behind the editor is redrawn with it.
+    setSize (360, 320); // Compact footprint to fit three faders, the analyser and the built-in keyboard.
 
     const auto configureSlider = [] (juce::Slider& slider)
     {
@@ -23,6 +26,7 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
     {
         label.setText (text, juce::dontSendNotification);
         label.setJustificationType (juce::Justification::centred);
+        label.setBufferedToImage (true);   // Static text: rendered once, then composited from the image.
         addAndMakeVisible (label);
     };
 
@@ -34,9 +38,18 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
     pulseWidthSlider.setTooltip ("Blend between thin and wide pulse timbres");
     filterCutoffSlider.setTooltip ("0 = smooth/open, 1 = sharp/filtered");
 
+    for (const auto rate : { 15, 30, 60 })
+        refreshRateBox.addItem (juce::String (rate) + " Hz", rate);
+
+    refreshRateBox.setSelectedId (processorRef.getEditorRefreshRate(), juce::dontSendNotification);
+    refreshRateBox.setTooltip ("Meter refresh rate; lower rates leave more CPU to the audio on busy machines");
+    refreshRateBox.onChange = [this] { processorRef.setEditorRefreshRate (refreshRateBox.getSelectedId()); };
+
     addAndMakeVisible (gainSlider);
     addAndMakeVisible (pulseWidthSlider);
     addAndMakeVisible (filterCutoffSlider);
+    addAndMakeVisible (refreshRateBox);
+    addAndMakeVisible (analyser);
     addAndMakeVisible (midiKeyboard);
 
     midiKeyboard.setAvailableRange (36, 96); // Limit to a practical register for testing.
@@ -46,30 +59,143 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor (AudioPluginAud
     gainAttachment = std::make_unique<SliderAttachment> (valueTree, "gain", gainSlider);             // Binds slider to APVTS.
     pulseWidthAttachment = std::make_unique<SliderAttachment> (valueTree, "pulseWidth", pulseWidthSlider);
     filterAttachment = std::make_unique<SliderAttachment> (valueTree, "filterCutoff", filterCutoffSlider);
+
+    meterDecibels.fill (meterFloorDecibels);
+    processorRef.setOutputMeteringEnabled (true);
 }
 
 AudioPluginAudioProcessorEditor::~AudioPluginAudioProcessorEditor()
 {
+    processorRef.setOutputMeteringEnabled (false);
 }
 
 //==============================================================================
 void AudioPluginAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // Drawn at the physical pixel scale, so the cached image stays sharp on high-DPI displays.
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (! background.isValid() || ! juce::approximatelyEqual (scale, backgroundScale))
+    {
+        background = juce::Image (juce::Image::RGB, juce::jmax (1, juce::roundToInt (static_cast<float> (getWidth()) * scale)),
+                                  juce::jmax (1, juce::roundToInt (static_cast<float> (getHeight()) * scale)), false);
+        juce::Graphics imageGraphics (background);
+        imageGraphics.addTransform (juce::AffineTransform::scale (scale));
+        drawBackground (imageGraphics);
+        backgroundScale = scale;
+    }
+
+    g.drawImage (background, getLocalBounds().toFloat());
+
+    g.setColour (juce::Colours::white.withAlpha (0.6f));
+    g.setFont (12.0f);
+    g.drawFittedText (statusText, getStatusArea(), juce::Justification::centred, 1);
+
+    g.setColour (juce::Colours::limegreen);
+
+    for (size_t channel = 0; channel < meterHeights.size(); ++channel)
+        g.fillRect (getMeterBarArea (channel).removeFromBottom (meterHeights[channel]));
+}
+
+void AudioPluginAudioProcessorEditor::drawBackground (juce::Graphics& g) const
 {
     g.fillAll (juce::Colours::black);
 
     g.setColour (juce::Colours::white.withAlpha (0.85f));
     g.setFont (20.0f);
     g.drawFittedText ("Anti-Aliased Synth", getLocalBounds().removeFromTop (30), juce::Justification::centred, 1); // Simple title banner.
+
+    g.setColour (juce::Colours::white.withAlpha (0.15f));
+
+    for (size_t channel = 0; channel < meterHeights.size(); ++channel)
+        g.fillRect (getMeterBarArea (channel));
+}
+
+// Called on every vertical blank; does nothing until the chosen frame interval has passed.
+void AudioPluginAudioProcessorEditor::refresh()
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    const auto elapsed = now - lastFrameTime;
+
+    // A little early still counts, or vsync jitter would halve a rate equal to the display's.
+    if (elapsed < 0.9 / processorRef.getEditorRefreshRate())
+        return;
+
+    lastFrameTime = now;
+    updateMeters (juce::jmin (elapsed, 1.0));
+    analyser.update (processorRef.getSampleRate());
+
+    if (now - lastStatusTime >= statusIntervalSeconds)
+    {
+        lastStatusTime = now;
+        updateStatus();
+    }
+}
+
+// Each bar repaints only the strip between its old and new heights.
+void AudioPluginAudioProcessorEditor::updateMeters (double elapsedSeconds)
+{
+    for (size_t channel = 0; channel < meterDecibels.size(); ++channel)
+    {
+        const auto peak = juce::Decibels::gainToDecibels (processorRef.getAndResetOutputPeak (static_cast<int> (channel)), meterFloorDecibels);
+        const auto fallen = meterDecibels[channel] - static_cast<float> (elapsedSeconds) * meterFallDecibelsPerSecond;
+        meterDecibels[channel] = juce::jmax (peak, fallen, meterFloorDecibels);
+
+        const auto bar = getMeterBarArea (channel);
+        const auto proportion = (meterDecibels[channel] - meterFloorDecibels) / -meterFloorDecibels;
+        const auto height = juce::roundToInt (juce::jlimit (0.0f, 1.0f, proportion) * static_cast<float> (bar.getHeight()));
+
+        if (height == meterHeights[channel])
+            continue;
+
+        const auto low = juce::jmin (height, meterHeights[channel]);
+        const auto high = juce::jmax (height, meterHeights[channel]);
+        repaint (bar.withTop (bar.getBottom() - high).withBottom (bar.getBottom() - low));
+        meterHeights[channel] = height;
+    }
+}
+
+// Audio-thread load and overruns, so a glitching session can be diagnosed from the plugin window.
+void AudioPluginAudioProcessorEditor::updateStatus()
+{
+    const auto& summary = processorRef.getInstrumentation().getSummary();
+    auto newText = juce::String::formatted ("DSP %.1f %% (peak %.1f %%)  |  %d voices  |  %lld overruns",
+                                            summary.averageLoad * 100.0, summary.peakLoad * 100.0, summary.activeVoices,
+                                            static_cast<long long> (summary.numOverruns));
+
+    if (newText != statusText)
+    {
+        statusText = std::move (newText);
+        repaint (getStatusArea());
+    }
+}
+
+juce::Rectangle<int> AudioPluginAudioProcessorEditor::getStatusArea() const
+{
+    return getLocalBounds().withTrimmedTop (28).withHeight (16);
+}
+
+juce::Rectangle<int> AudioPluginAudioProcessorEditor::getMeterBarArea (size_t channel) const
+{
+    const auto barWidth = meterArea.getWidth() / static_cast<int> (meterHeights.size());
+    return meterArea.withX (meterArea.getX() + barWidth * static_cast<int> (channel)).withWidth (barWidth).reduced (1, 0);
 }
 
 void AudioPluginAudioProcessorEditor::resized()
 {
+    background = {};   // Redrawn for the new size at the next paint().
+
     auto area = getLocalBounds().reduced (20);
 
     auto headerArea = area.removeFromTop (40); // Reserve space for the title text.
     juce::ignoreUnused (headerArea);
+    refreshRateBox.setBounds (getLocalBounds().removeFromTop (28).removeFromRight (70).reduced (4)); // Clear of the centred title.
 
     auto controlArea = area.removeFromTop (110); // Three faders live in this row.
+    meterArea = controlArea.removeFromRight (12).reduced (0, 10);
+
+    area.removeFromTop (10);
+    analyser.setBounds (area.removeFromTop (90));
 
     auto keyboardArea = area;
     keyboardArea.removeFromTop (10); // Small gap between faders and keyboard.
@@ -1,11 +1,17 @@
 #pragma once
 
+#include "AnalyserComponent.h"
 #include "PluginProcessor.h"
 
 #include <juce_audio_utils/juce_audio_utils.h>
+#include <array>
 #include <memory>
 
 //==============================================================================
+// Everything that never changes (background, title, meter frames) is drawn once into a cached image, rebuilt only
+// on a resize or a display scale change. The meters and the status line are refreshed from the display's vertical
+// blank, at most at the rate the user picks, and repaint only the parts that moved. The analyser redraws at the
+// same rate, and only while output arrives.
 class AudioPluginAudioProcessorEditor final : public juce::AudioProcessorEditor
 {
 public:
@@ -17,6 +23,17 @@ public:
     void resized() override;
 
 private:
+    static constexpr double statusIntervalSeconds = 0.2;   // The instrumentation summary itself only refreshes at 10 Hz.
+    static constexpr float meterFloorDecibels = -60.0f;
+    static constexpr float meterFallDecibelsPerSecond = 30.0f;
+
+    void refresh();
+    void updateMeters (double elapsedSeconds);
+    void updateStatus();
+    void drawBackground (juce::Graphics& g) const;
+    juce::Rectangle<int> getStatusArea() const;
+    juce::Rectangle<int> getMeterBarArea (size_t channel) const;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     AudioPluginAudioProcessor& processorRef;
@@ -27,13 +44,26 @@ private:
     juce::Label gainLabel;
     juce::Label pulseWidthLabel;
     juce::Label filterCutoffLabel;
+    juce::ComboBox refreshRateBox;       // Meter frames per second.
 
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     std::unique_ptr<SliderAttachment> gainAttachment;        // Wires the Gain slider to the processor parameter.
     std::unique_ptr<SliderAttachment> pulseWidthAttachment;  // Wires the Pulse Width slider to the processor parameter.
     std::unique_ptr<SliderAttachment> filterAttachment;      // Wires the Filter Cutoff slider to the processor parameter.
 
+    juce::String statusText;                                 // Latest DSP load summary, refreshed every statusIntervalSeconds.
+
     juce::MidiKeyboardComponent midiKeyboard;                // Built-in keyboard so users can trigger notes without external gear.
+    AnalyserComponent analyser;                              // Scope and spectrum of the output, for checking aliasing by eye.
+
+    juce::Image background;                                  // The static layers, at the display's pixel scale.
+    float backgroundScale = 0.0f;                            // Scale the background was drawn for.
+    juce::Rectangle<int> meterArea;                          // Output meters, beside the faders.
+    std::array<float, AudioPluginAudioProcessor::maxMeteredChannels> meterDecibels {};   // Displayed levels, falling between peaks.
+    std::array<int, AudioPluginAudioProcessor::maxMeteredChannels> meterHeights {};      // Bar heights last painted, in pixels.
+    double lastFrameTime = 0.0, lastStatusTime = 0.0;        // Seconds, on the high-resolution counter.
+
+    juce::VBlankAttachment vBlankAttachment;                 // Last, so no frame arrives before the rest is built.
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessorEditor)
 };
\ No newline at end of file
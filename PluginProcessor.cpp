@@ -1,252 +1,77 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "ParameterIDs.h"
 
-#include <juce_dsp/juce_dsp.h>
-#include <cmath>
 #include <vector>
-// Extra headers pull in the DSP helpers we needed to hand-roll anti-aliased oscillators for the assignment deliverable.
 
 namespace
 {
-// Shared constants for the oscillators and APVTS parameter IDs.
-// Keeping them in one namespace makes it easy to cross-wire the DSP code and parameter layout without string duplication.
-constexpr float hfCompA0 = 2.5f;
-constexpr float hfCompA1 = -1.5f;
-constexpr float minNorm = 0.001f;
-constexpr auto gainParamID = "gain";
-constexpr auto pulseWidthParamID = "pulseWidth";
-constexpr auto filterCutoffParamID = "filterCutoff";
-}
-
-// This lightweight Sound object lets every custom voice respond to all incoming MIDI notes/channels.
-class AntiAliasedSound final : public juce::SynthesiserSound
-{
-public:
-    bool appliesToNote (int) override    { return true; }
-    bool appliesToChannel (int) override { return true; }
-};
+// Saved state: a magic number and a format version, then the APVTS tree as ValueTree::writeToStream() writes it.
+// Sessions saved before this format hold copyXmlToBinary() XML, which has a magic number of its own.
+constexpr int stateMagic = 0x54535044;   // "DPST" in the stream's little-endian order.
+constexpr int stateVersion = 1;
+constexpr int stateHeaderSize = 8;
 
-class AntiAliasedVoice final : public juce::SynthesiserVoice
+juce::ValueTree readState (const void* data, int sizeInBytes)
 {
-public:
-    explicit AntiAliasedVoice (juce::AudioProcessorValueTreeState& vts)
-    {
-        gainParam = vts.getRawParameterValue (gainParamID);
-        pulseWidthParam = vts.getRawParameterValue (pulseWidthParamID);
-        filterCutoffParam = vts.getRawParameterValue (filterCutoffParamID);
+    if (data == nullptr || sizeInBytes <= 0)
+        return {};
 
-        jassert (gainParam != nullptr);
-        jassert (pulseWidthParam != nullptr);
-        jassert (filterCutoffParam != nullptr);
+    juce::MemoryInputStream stream (data, static_cast<size_t> (sizeInBytes), false);
 
-        // Cache raw parameter pointers once so renderNextBlock can read them lock-free.
-    }
-
-    bool canPlaySound (juce::SynthesiserSound* sound) override
+    if (sizeInBytes >= stateHeaderSize && stream.readInt() == stateMagic)
     {
-        return dynamic_cast<AntiAliasedSound*> (sound) != nullptr;
-    }
+        if (stream.readInt() > stateVersion)
+            return {};   // Written by a newer build: its tree may not mean the same thing here.
 
-    // Handle per-note initialisation so every voice restarts with the latest GUI parameters.
-    void startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound*, int) override
-    {
-        const auto sampleRate = getSampleRate();
-        if (sampleRate <= 0.0)
-        {
-            clearCurrentNote();
-            return;
-        }
-
-        currentLevel = velocity;
-        currentFrequency = static_cast<float> (juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber));
-        pulseOsc.reset();
-        pulseOsc.setPulseWidth (pulseWidthParam->load());
-        pulseOsc.setFrequency (currentFrequency, sampleRate);
-        currentSampleRate = sampleRate;
-        updateFilterCoefficients();
-        lowPassFilter.reset();
-        isActive = true;
+        return juce::ValueTree::readFromStream (stream);
     }
 
-    // Hard-stop the voice and clear state because the brief did not call for tails or envelopes.
-    void stopNote (float, bool allowTailOff) override
-    {
-        juce::ignoreUnused (allowTailOff);
-        clearCurrentNote();
-        pulseOsc.reset();
-        isActive = false;
-        currentLevel = 0.0f;
-    }
+    if (auto xml = juce::AudioProcessor::getXmlFromBinary (data, sizeInBytes))
+        return juce::ValueTree::fromXml (*xml);
 
-    void pitchWheelMoved (int) override {}
-    void controllerMoved (int, int) override {}
-
-    // This is the per-sample DSP loop where the anti-aliased pulse oscillator and per-voice filter run.
-    void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override
-    {
-        if (! isVoiceActive() || ! isActive)
-            return;
-
-        const auto sampleRate = getSampleRate();
-        if (sampleRate <= 0.0)
-            return;
-
-        pulseOsc.setFrequency (currentFrequency, sampleRate);
-        pulseOsc.setPulseWidth (pulseWidthParam->load());
-
-        currentSampleRate = sampleRate;
-        const auto smoothingAmount = filterCutoffParam->load();
-        if (std::abs (smoothingAmount - lastFilterCutoff) > 1.0e-3f)
-        {
-            lastFilterCutoff = smoothingAmount;
-            updateFilterCoefficients();
-        }
-
-        const auto gain = juce::Decibels::decibelsToGain (gainParam->load());
-
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            const auto rawValue = pulseOsc.getNextSample() * currentLevel * gain;
-            const auto value = lowPassFilter.processSingleSampleRaw (rawValue);
-
-            for (int channel = 0; channel < outputBuffer.getNumChannels(); ++channel)
-                outputBuffer.addSample (channel, startSample + sample, value);
-        }
-    }
-
-private:
-    // Per-voice IIR filter keeps the alias-reduction brief satisfied while tracking the virtual smooth/sharp control.
-    void updateFilterCoefficients()
-    {
-        if (currentSampleRate <= 0.0)
-            return;
-
-        const auto smoothingAmount = filterCutoffParam->load();
-        const auto maxCutoff = static_cast<float> (currentSampleRate * 0.45);
-        const auto minCutoff = 200.0f;
-        const auto cutoff = juce::jmap (smoothingAmount, 0.0f, 1.0f, maxCutoff, minCutoff);
-        const auto coeffs = juce::IIRCoefficients::makeLowPass (currentSampleRate, cutoff);
-        lowPassFilter.setCoefficients (coeffs);
-    }
-
-    AntiAliasedPulseOscillator pulseOsc;
-    float currentLevel = 0.0f;
-    float currentFrequency = 0.0f;
-    bool isActive = false;
-    std::atomic<float>* gainParam = nullptr;
-    std::atomic<float>* pulseWidthParam = nullptr;
-    std::atomic<float>* filterCutoffParam = nullptr;
-    juce::IIRFilter lowPassFilter;
-    double currentSampleRate = 44100.0;
-    float lastFilterCutoff = -1.0f;
-};
-
-// Feedback-FM + polynomial compensation keeps the saw harmonics controlled when the frequency changes.
-void AntiAliasedSawOscillator::setFrequency (float newFrequency, double newSampleRate) noexcept
-{
-    if (newSampleRate <= 0.0)
-        return;
-
-    const auto normalised = static_cast<float> (newFrequency / static_cast<float> (newSampleRate));
-    w = juce::jlimit (0.0f, 0.49f, normalised);
-    const auto diff = 0.5f - w;
-    beta = 13.0f * diff * diff * diff * diff;
-}
-
-// Generate one anti-aliased saw sample that forms the building block for the pulse oscillator edges.
-float AntiAliasedSawOscillator::getNextSample() noexcept
-{
-    const auto feedbackPhase = phase + (osc * beta);
-    const auto input = std::sin (juce::MathConstants<float>::twoPi * feedbackPhase);
-    osc = 0.5f * (osc + input);
-
-    const auto filtered = (hfCompA0 * osc) + (hfCompA1 * previousInput);
-    previousInput = osc;
-
-    const auto dc = 0.376f - (0.752f * w);
-    const auto norm = juce::jmax (minNorm, 1.0f - (2.0f * w));
-    const auto sample = (filtered - dc) / norm;
-
-    phase += w;
-    if (phase >= 1.0f)
-        phase -= 1.0f;
-
-    return sample;
-}
-
-void AntiAliasedSawOscillator::reset() noexcept
-{
-    phase = 0.0f;
-    osc = 0.0f;
-    previousInput = 0.0f;
-}
-
-// Both edges share the incoming frequency so we can reuse the saw core for the pulse waveform.
-void AntiAliasedPulseOscillator::setFrequency (float newFrequency, double newSampleRate) noexcept
-{
-    leadingEdge.setFrequency (newFrequency, newSampleRate);
-    trailingEdge.setFrequency (newFrequency, newSampleRate);
-}
-
-// Pulse width modulation is clamped to avoid degeneracies but still satisfies the UI requirement.
-void AntiAliasedPulseOscillator::setPulseWidth (float newPulseWidth) noexcept
-{
-    pulseWidth = juce::jlimit (0.01f, 0.99f, newPulseWidth);
+    return {};
 }
 
-// Compose two phase-shifted saw waves to obtain the anti-aliased pulse output.
-float AntiAliasedPulseOscillator::getNextSample() noexcept
+// A synth also offers an output bus for each multi-timbral part after the first, off until the host enables it.
+juce::AudioProcessor::BusesProperties createBusesProperties()
 {
-    const auto leading = leadingEdge.getNextSample();
-
-    auto shiftedPhase = leadingEdge.phase + pulseWidth;
-    while (shiftedPhase >= 1.0f)
-        shiftedPhase -= 1.0f;
-
-    auto& t = trailingEdge;
-    const auto feedbackPhase = shiftedPhase + (t.osc * t.beta);
-    const auto input = std::sin (juce::MathConstants<float>::twoPi * feedbackPhase);
-    t.osc = 0.5f * (t.osc + input);
-
-    const auto filtered = (hfCompA0 * t.osc) + (hfCompA1 * t.previousInput);
-    t.previousInput = t.osc;
-
-    const auto dc = 0.376f - (0.752f * t.w);
-    const auto norm = juce::jmax (minNorm, 1.0f - (2.0f * t.w));
-    const auto trailing = (filtered - dc) / norm;
-
-    t.phase = shiftedPhase + t.w;
-    if (t.phase >= 1.0f)
-        t.phase -= 1.0f;
-
-    const auto pulse = juce::jlimit (-1.0f, 1.0f, leading - trailing);
-    return pulse;
+    juce::AudioProcessor::BusesProperties buses;
+   #if ! JucePlugin_IsMidiEffect
+    #if ! JucePlugin_IsSynth
+    buses = buses.withInput ("Input", juce::AudioChannelSet::stereo(), true);
+    #endif
+    buses = buses.withOutput ("Output", juce::AudioChannelSet::stereo(), true);
+    #if JucePlugin_IsSynth
+    for (int part = 2; part <= MultiTimbralParts::numParts; ++part)
+        buses = buses.withOutput ("Part " + juce::String (part), juce::AudioChannelSet::stereo(), false);
+    #endif
+   #endif
+    return buses;
 }
-
-void AntiAliasedPulseOscillator::reset() noexcept
-{
-    leadingEdge.reset();
-    trailingEdge.reset();
 }
 
 //==============================================================================
 AudioPluginAudioProcessor::AudioPluginAudioProcessor()
-         : AudioProcessor (BusesProperties()
-                                         #if ! JucePlugin_IsMidiEffect
-                                            #if ! JucePlugin_IsSynth
-                                             .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                                            #endif
-                                             .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                                         #endif
-                                             ),
-           parameters (*this, nullptr, "Parameters", createParameterLayout())
-{
-    // Replace the default JUCE tone generator with eight of our custom voices to meet the polyphonic spec.
-    constexpr int numVoices = 8;
-    for (int i = 0; i < numVoices; ++i)
-        synth.addVoice (new AntiAliasedVoice (parameters));
-
+         : AudioProcessor (createBusesProperties()),
+           parameters (*this, nullptr, "Parameters", createParameterLayout()),
+           smoothedParameters (parameters),
+           presets (parameters),
+           parts (parameters, smoothedParameters, presets)
+{
+    // Every voice we may ever need is built here, once; the Polyphony parameter only enables pool slots.
+    synth.createVoicePool (smoothedParameters, *sharedTables, maxPolyphony);
     synth.addSound (new AntiAliasedSound());
+
+    polyphonyParam = parameters.getRawParameterValue (polyphonyParamID);
+    qualityParam = parameters.getRawParameterValue (qualityParamID);
+    releaseParam = parameters.getRawParameterValue (releaseParamID);
+    voiceStealingParam = parameters.getRawParameterValue (voiceStealingParamID);
+    multiTimbralParam = parameters.getRawParameterValue (multiTimbralParamID);
+    jassert (polyphonyParam != nullptr);
+    jassert (qualityParam != nullptr);
+    jassert (releaseParam != nullptr);
+    jassert (voiceStealingParam != nullptr);
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor() = default;
@@ -284,30 +109,34 @@ bool AudioPluginAudioProcessor::isMidiEffect() const
    #endif
 }
 
+// Released voices fade out over the release time, which is defined as the fall to silence, plus the decimator's delay
+// and ringing. After that the processor goes idle (see isIdle()), so a host that stops calling it then loses nothing.
 double AudioPluginAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    const auto release = static_cast<double> (releaseParam->load());
+    const auto decimatorTail = getLatencySamples() + decimator.getSettlingTimeInSamples();
+    return release + (lastSampleRate > 0.0 ? decimatorTail / lastSampleRate : 0.0);
 }
 
 int AudioPluginAudioProcessor::getNumPrograms()
 {
-    return 1;
+    return presets.getNumPrograms();
 }
 
 int AudioPluginAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return presets.getCurrentProgram();
 }
 
+// Only queues the change: the audio thread applies it at its next block (see PresetBank).
 void AudioPluginAudioProcessor::setCurrentProgram (int index)
 {
-    juce::ignoreUnused (index);
+    presets.selectProgram (index);
 }
 
 const juce::String AudioPluginAudioProcessor::getProgramName (int index)
 {
-    juce::ignoreUnused (index);
-    return {};
+    return presets.getProgramName (index);
 }
 
 void AudioPluginAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -318,11 +147,48 @@ void AudioPluginAudioProcessor::changeProgramName (int index, const juce::String
 //==============================================================================
 void AudioPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused (samplesPerBlock);
-
     // Store the host sample rate so the oscillators and filters stay numerically stable.
     lastSampleRate = sampleRate;
-    synth.setCurrentPlaybackSampleRate (sampleRate);
+    preparedBlockSize = juce::jmax (1, samplesPerBlock);
+
+    // Everything downstream of the MIDI is sized for the highest factor, so the engine can change while playing.
+    const auto engine = getTargetEngine();
+    const auto maxRenderBlockSize = preparedBlockSize * OversamplingDecimator::maxFactor;
+    const auto numChannels = juce::jmax (1, getTotalNumOutputChannels());
+
+    decimator.prepare (numChannels);
+    floatBuffers.oversampled.setSize (numChannels, maxRenderBlockSize);
+    floatBuffers.fade.setSize (numChannels, preparedBlockSize);
+    doubleBuffers.oversampled.setSize (numChannels, maxRenderBlockSize);
+    doubleBuffers.fade.setSize (numChannels, preparedBlockSize);
+    floatBuffers.chunk.setSize (numChannels, preparedBlockSize);
+    doubleBuffers.chunk.setSize (numChannels, preparedBlockSize);
+    oversampledMidi.ensureSize (4096);   // Dense blocks can still grow it; the copy is cleared, never shrunk.
+
+    // A bounce must not start on the fallback oscillators; only the first instance can wait here, and briefly.
+    if (isNonRealtime())
+        sharedTables->waitForSawWavetables();
+
+    instrumentation.prepare (sampleRate);
+    smoothedParameters.prepare (sampleRate, maxRenderBlockSize, engine.oversamplingFactor);
+    parts.prepare (sampleRate, maxRenderBlockSize, engine.oversamplingFactor);
+    synth.prepare (sampleRate * engine.oversamplingFactor, maxRenderBlockSize);
+    synth.setNumRenderWorkers (numRenderWorkers);
+
+    // Channel 1 and every part without an enabled bus of its own play into the main bus.
+    partOutputs.fill ({ nullptr, false, 0, getMainBusNumOutputChannels() });
+
+    for (int channel = 2; channel <= MultiTimbralParts::numParts; ++channel)
+        if (const auto* bus = getBus (false, channel - 1); bus != nullptr && bus->isEnabled() && bus->getNumberOfChannels() > 0)
+            partOutputs[static_cast<size_t> (channel - 1)] = { nullptr, false, getChannelIndexInProcessBlockBuffer (false, channel - 1, 0),
+                                                               bus->getNumberOfChannels() };
+
+    applyEngine (engine);
+    decimator.reset();
+    settlingSamplesRemaining = 0;
+
+    // Reported for the engine in use now; the factors' latencies differ by at most a sample.
+    setLatencySamples (decimator.getLatencyInSamples());
 }
 
 void AudioPluginAudioProcessor::releaseResources()
@@ -342,6 +208,11 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+   #else
+    // A part's bus is off or laid out like the main one.
+    for (int bus = 1; bus < layouts.outputBuses.size(); ++bus)
+        if (const auto& set = layouts.outputBuses.getReference (bus); ! set.isDisabled() && set != layouts.getMainOutputChannelSet())
+            return false;
    #endif
 
     return true;
@@ -350,8 +221,22 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 
 void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                               juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer, midiMessages);
+}
+
+void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                              juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer, midiMessages);
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    AudioThreadInstrumentation::BlockScope timing (instrumentation);
+
     if (lastSampleRate <= 0.0)
     {
         buffer.clear();
@@ -361,21 +246,320 @@ void AudioPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 
     // Merge events from the on-screen keyboard so the plugin can be demoed without external MIDI gear.
     keyboardState.processNextMidiBuffer (midiMessages, 0, buffer.getNumSamples(), true);
+    timing.midiMerged();
+
+    // MIDI program changes select from the bank too. Read from the raw bytes, as a MidiMessage copy of a long
+    // SysEx would allocate; whichever program is queued then applies before the block's parameters are smoothed.
+    // In multi-timbral mode a program change on channels 2-16 is that channel's part's.
+    const auto multiTimbral = multiTimbralParam->load() >= 0.5f;
+
+    for (const auto metadata : midiMessages)
+    {
+        if (metadata.numBytes < 2 || (metadata.data[0] & 0xf0) != 0xc0)
+            continue;
+
+        if (const auto channel = (metadata.data[0] & 0x0f) + 1; multiTimbral && channel > 1)
+            parts.selectProgram (channel, metadata.data[1]);
+        else
+            presets.selectProgram (metadata.data[1]);
+    }
+
+    presets.applyPendingProgram();
+    parts.applyPendingPrograms();
+    updateChannelRouting (multiTimbral);
 
     buffer.clear();
-    // Delegate the heavy lifting to juce::Synthesiser so each AntiAliasedVoice renders into the buffer.
-    synth.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
+    synth.setNumEnabledVoices (static_cast<int> (polyphonyParam->load()));
+    synth.setStealingPolicy (voiceStealingParam->load() >= 0.5f ? AntiAliasedSynthesiser::StealingPolicy::quietest
+                                                                 : AntiAliasedSynthesiser::StealingPolicy::oldest);
+
+    // Nothing to render: the cleared buffer is the output. With no note sounding an engine change needs no crossfade.
+    if (isIdle (midiMessages, buffer.getNumSamples()))
+    {
+        if (const auto engine = getTargetEngine(); engine != currentEngine)
+            applyEngine (engine);
+
+        analyserTap.push (buffer, partOutputs.front().numOutputChannels, buffer.getNumSamples());
+        timing.finish (buffer.getNumSamples(), 0);
+        return;
+    }
+
+    if (const auto engine = getTargetEngine(); engine != currentEngine)
+        switchEngine (engine, buffer, midiMessages, timing);
+    else
+        renderBlock (buffer, midiMessages, buffer.getNumSamples(), timing);
+
+    // The analyser sees exactly what the host gets: the main bus, after gain and decimation.
+    updateOutputPeaks (buffer);
+    analyserTap.push (buffer, partOutputs.front().numOutputChannels, buffer.getNumSamples());
     midiMessages.clear();
+    timing.finish (buffer.getNumSamples(), synth.getNumActiveVoices());
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::renderBlock (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages, int numSamples,
+                                             AudioThreadInstrumentation::BlockScope& timing) noexcept
+{
+    if (decimator.getFactor() > 1)
+    {
+        renderOversampled (buffer, midiMessages, numSamples, timing);
+        return;
+    }
+
+    if (numSamples <= preparedBlockSize)
+    {
+        renderChunk (buffer, midiMessages, numSamples, timing);
+        return;
+    }
+
+    // A host block bigger than announced is rendered in chunks of the prepared size, each through the chunk buffer
+    // from its first sample, so the shared ramps always cover it and the voices index them from 0. A view of the
+    // host's buffer would do, but JUCE allocates the pointer table of a view with 32 channels or more.
+    auto& chunk = getRenderBuffers<SampleType>().chunk;
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), chunk.getNumChannels());
+
+    for (int start = 0; start < numSamples; start += preparedBlockSize)
+    {
+        const auto chunkSize = juce::jmin (preparedBlockSize, numSamples - start);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            chunk.copyFrom (channel, 0, buffer, channel, start, chunkSize);
+
+        copyChunkMidi (midiMessages, start, chunkSize, 1);
+        renderChunk (chunk, oversampledMidi, chunkSize, timing);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.copyFrom (channel, start, chunk, channel, 0, chunkSize);
+    }
+}
+
+// One run of at most the prepared block size at the output rate, from the buffer's first sample.
+template <typename SampleType>
+void AudioPluginAudioProcessor::renderChunk (juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages,
+                                             int numSamples, AudioThreadInstrumentation::BlockScope& timing) noexcept
+{
+    smoothedParameters.process (numSamples);
+    parts.process (numSamples);
+
+    // Delegate the heavy lifting to juce::Synthesiser so each AntiAliasedVoice renders into the buffer.
+    synth.renderNextBlock (buffer, midiMessages, 0, numSamples);
+    timing.voicesRendered();
+
+    smoothedParameters.applyGain (buffer, numSamples);
+    timing.outputMixed();
+}
+
+// Voices render at factor x the output rate, in chunks of at most the prepared block size so a host that sends
+// a bigger block than announced still fits the buffers. Each chunk is decimated once, however many voices sound.
+template <typename SampleType>
+void AudioPluginAudioProcessor::renderOversampled (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages, int numSamples,
+                                                   AudioThreadInstrumentation::BlockScope& timing) noexcept
+{
+    const auto factor = decimator.getFactor();
+    auto& oversampledBuffer = getRenderBuffers<SampleType>().oversampled;
+
+    for (int start = 0; start < numSamples; start += preparedBlockSize)
+    {
+        const auto chunkSize = juce::jmin (preparedBlockSize, numSamples - start);
+        const auto renderSize = chunkSize * factor;
+
+        copyChunkMidi (midiMessages, start, chunkSize, factor);
+        oversampledBuffer.clear (0, renderSize);
+        smoothedParameters.process (renderSize);
+        parts.process (renderSize);
+        synth.renderNextBlock (oversampledBuffer, oversampledMidi, 0, renderSize);
+        timing.voicesRendered();
+
+        smoothedParameters.applyGain (oversampledBuffer, renderSize);
+        decimator.process (oversampledBuffer, buffer, start, chunkSize);
+        timing.outputMixed();
+    }
+}
+
+// Copies the events of one chunk of the host's block into oversampledMidi, timestamped from the chunk's start at
+// the render rate.
+void AudioPluginAudioProcessor::copyChunkMidi (const juce::MidiBuffer& midiMessages, int start, int numSamples, int factor) noexcept
+{
+    oversampledMidi.clear();
+
+    for (auto it = midiMessages.findNextSamplePosition (start); it != midiMessages.end(); ++it)
+    {
+        const auto event = *it;
+
+        if (event.samplePosition >= start + numSamples)
+            break;
+
+        oversampledMidi.addEvent (event.data, event.numBytes, (event.samplePosition - start) * factor);
+    }
+}
+
+// Sounding notes carry on through a switch. The outgoing engine renders the start of the block from the voices'
+// current state and parameter ramps without this block's MIDI; the voices and ramps are then rewound, the incoming
+// engine renders the whole block, and the two are crossfaded. The decimator restarts from silence, which the
+// fade-in hides.
+template <typename SampleType>
+void AudioPluginAudioProcessor::switchEngine (const Engine& newEngine, juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages,
+                                              AudioThreadInstrumentation::BlockScope& timing) noexcept
+{
+    auto& fadeBuffer = getRenderBuffers<SampleType>().fade;
+    const auto numSamples = buffer.getNumSamples();
+    const auto fadeLength = juce::jmin (numSamples, fadeBuffer.getNumSamples());
+
+    synth.saveVoiceStates();
+    smoothedParameters.saveState();
+    parts.saveStates();
+    fadeBuffer.clear();
+    renderBlock (fadeBuffer, noMidi, fadeLength, timing);
+    synth.restoreVoiceStates();
+    smoothedParameters.restoreState();
+    parts.restoreStates();
+
+    applyEngine (newEngine);
+    decimator.reset();
+    renderBlock (buffer, midiMessages, numSamples, timing);
+
+    for (int channel = 0; channel < juce::jmin (buffer.getNumChannels(), fadeBuffer.getNumChannels()); ++channel)
+    {
+        buffer.applyGainRamp (channel, 0, fadeLength, SampleType (0), SampleType (1));
+        buffer.addFromWithRamp (channel, 0, fadeBuffer.getReadPointer (channel), fadeLength, SampleType (1), SampleType (0));
+    }
+}
+
+void AudioPluginAudioProcessor::applyEngine (const Engine& engine) noexcept
+{
+    decimator.setFactor (engine.oversamplingFactor);
+    smoothedParameters.setOversamplingFactor (engine.oversamplingFactor);
+    parts.setOversamplingFactor (engine.oversamplingFactor);
+    synth.setRenderSampleRate (lastSampleRate * engine.oversamplingFactor);
+    synth.setHighPrecision (engine.highPrecision);
+    synth.setMinimumSubBlockSize (minimumSubBlockSize * engine.oversamplingFactor);
+    currentEngine = engine;
+}
+
+// Idle blocks are silent and leave the peaks alone; the editor's meters fall back on their own.
+template <typename SampleType>
+void AudioPluginAudioProcessor::updateOutputPeaks (const juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    if (! outputMeteringEnabled.load())
+        return;
+
+    const auto numChannels = juce::jmin (maxMeteredChannels, partOutputs.front().numOutputChannels, buffer.getNumChannels());
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto peak = static_cast<float> (buffer.getMagnitude (channel, 0, buffer.getNumSamples()));
+        auto& stored = outputPeaks[static_cast<size_t> (channel)];
+        auto previous = stored.load();
+
+        while (peak > previous && ! stored.compare_exchange_weak (previous, peak))
+        {
+        }
+    }
+}
+
+float AudioPluginAudioProcessor::getAndResetOutputPeak (int channel) noexcept
+{
+    return juce::isPositiveAndBelow (channel, maxMeteredChannels) ? outputPeaks[static_cast<size_t> (channel)].exchange (0.0f) : 0.0f;
+}
+
+// The synth reads a channel's routing at each note-on, so a part taking a program, or the mode switching, changes
+// only the notes after it. A part with parameters of its own also has its own gain, under the main Gain.
+void AudioPluginAudioProcessor::updateChannelRouting (bool multiTimbral) noexcept
+{
+    synth.setMultiTimbral (multiTimbral);
+
+    for (int channel = 1; channel <= MultiTimbralParts::numParts; ++channel)
+    {
+        auto routing = partOutputs[multiTimbral ? static_cast<size_t> (channel - 1) : 0];
+
+        if (multiTimbral && parts.hasOwnParameters (channel))
+        {
+            routing.parameters = &parts.getParameters (channel);
+            routing.appliesPartGain = true;
+        }
+
+        synth.setChannelRouting (channel, routing);
+    }
+}
+
+// Idle once no voice has sounded for long enough that the decimator's ringing has died away, and until the next MIDI
+// event. Idle blocks render nothing and leave the parameter ramps where they were; they resume from there.
+bool AudioPluginAudioProcessor::isIdle (const juce::MidiBuffer& midiMessages, int numSamples) noexcept
+{
+    if (! midiMessages.isEmpty() || synth.getNumActiveVoices() > 0)
+    {
+        settlingSamplesRemaining = decimator.getSettlingTimeInSamples();
+        return false;
+    }
+
+    if (settlingSamplesRemaining <= 0)
+        return true;
+
+    // Still rendered, to let the ringing out; whatever is left once it has settled is below -120 dB and dropped.
+    settlingSamplesRemaining -= numSamples;
+
+    if (settlingSamplesRemaining <= 0)
+        decimator.reset();
+
+    return false;
+}
+
+AudioPluginAudioProcessor::Engine AudioPluginAudioProcessor::getTargetEngine() const noexcept
+{
+    if (isNonRealtime())
+        return { OversamplingDecimator::maxFactor, true };
+
+    return { getOversamplingFactor (getRenderQuality()), false };
+}
+
+AudioPluginAudioProcessor::RenderQuality AudioPluginAudioProcessor::getRenderQuality() const noexcept
+{
+    return static_cast<RenderQuality> (juce::jlimit (0, 2, static_cast<int> (qualityParam->load())));
+}
+
+int AudioPluginAudioProcessor::getOversamplingFactor (RenderQuality quality) noexcept
+{
+    switch (quality)
+    {
+        case RenderQuality::draft:  return 1;
+        case RenderQuality::live:   return 2;
+        case RenderQuality::render: return 4;
+    }
+
+    return 1;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginAudioProcessor::createParameterLayout()
 {
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
 
-    // These three parameters back the GUI sliders and feed directly into the per-voice DSP code above.
+    // The first three parameters back the GUI sliders and feed directly into the per-voice DSP code above.
     params.push_back (std::make_unique<juce::AudioParameterFloat> (gainParamID, "Gain", juce::NormalisableRange<float> (-60.0f, 0.0f, 0.1f), -12.0f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> (pulseWidthParamID, "Pulse Width", juce::NormalisableRange<float> (0.05f, 0.95f, 0.001f), 0.5f));
     params.push_back (std::make_unique<juce::AudioParameterFloat> (filterCutoffParamID, "Virtual Filter", juce::NormalisableRange<float> (0.0f, 1.0f, 0.001f), 0.5f));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (filterTypeParamID, "Filter Type", juce::StringArray { "Biquad", "SVF" }, 1));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (oscillatorEngineParamID, "Oscillator", juce::StringArray { "Feedback FM", "Wavetable" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterInt> (polyphonyParamID, "Polyphony", 1, maxPolyphony, 8));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (voiceStealingParamID, "Voice Stealing", juce::StringArray { "Oldest", "Quietest" }, 0));
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (qualityParamID, "Quality", juce::StringArray { "Draft", "Live", "Render" }, 1));
+
+    // Amplitude envelope; the skew gives the short times most of the travel.
+    const juce::NormalisableRange<float> envelopeTimeRange (0.0f, 5.0f, 0.0f, 0.3f);
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (attackParamID, "Attack", envelopeTimeRange, 0.002f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (decayParamID, "Decay", envelopeTimeRange, 0.2f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (sustainParamID, "Sustain", juce::NormalisableRange<float> (0.0f, 1.0f, 0.001f), 1.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (releaseParamID, "Release", envelopeTimeRange, 0.05f));
+
+    // Unison: detuned layers per note, sharing the note's filter and envelope.
+    params.push_back (std::make_unique<juce::AudioParameterInt> (unisonVoicesParamID, "Unison Voices", 1, UnisonOscillator::maxLayers, 1));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (unisonDetuneParamID, "Unison Detune", juce::NormalisableRange<float> (0.0f, 100.0f, 0.1f), 20.0f));
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (unisonSpreadParamID, "Unison Spread", juce::NormalisableRange<float> (0.0f, 1.0f, 0.001f), 0.5f));
+
+    // MPE: member channels 2-16 bend their own notes by this much; channel 1, the master channel, bends every note by 2.
+    params.push_back (std::make_unique<juce::AudioParameterInt> (mpeBendRangeParamID, "MPE Bend Range", 0, 96, 48));
+
+    // Multi-timbral: each MIDI channel plays a part of its own instead (see MultiTimbralParts).
+    params.push_back (std::make_unique<juce::AudioParameterBool> (multiTimbralParamID, "Multi-Timbral", false));
 
     return { params.begin(), params.end() };
 }
@@ -418,17 +602,35 @@ juce::AudioProcessorEditor* AudioPluginAudioProcessor::createEditor()
 //==============================================================================
 void AudioPluginAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // Persist the APVTS state so the host recalls our custom parameters with the session.
-    if (auto state = parameters.copyState(); auto xml = state.createXml())
-        copyXmlToBinary (*xml, destData);
+    // Persist the APVTS state so the host recalls our custom parameters with the session. Written straight into
+    // destData in the binary format, so there is no XML document or text to build on every host autosave.
+    juce::MemoryOutputStream stream (destData, false);
+    stream.writeInt (stateMagic);
+    stream.writeInt (stateVersion);
+
+    auto state = parameters.copyState();
+    parts.writeState (state);
+    state.writeToStream (stream);
 }
 
 void AudioPluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // Restore the saved parameter tree to keep GUI, voices, and host automation in sync after reload.
-    if (auto xml = getXmlFromBinary (data, sizeInBytes))
-        if (xml->hasTagName (parameters.state.getType()))
-            parameters.replaceState (juce::ValueTree::fromXml (*xml));
+    auto state = readState (data, sizeInBytes);
+
+    if (! state.isValid() || ! state.hasType (parameters.state.getType()))
+        return;
+
+    // The parts' programs travel with the parameters but aren't parameters themselves.
+    parts.readState (state);
+    state.removeChild (state.getChildWithName (MultiTimbralParts::stateType), nullptr);
+
+    // Hosts restore the state they already hold (undo snapshots, re-opening a session); replacing it would
+    // notify every parameter and attachment for nothing.
+    if (state.isEquivalentTo (parameters.copyState()))
+        return;
+
+    parameters.replaceState (state);
 }
 
 //==============================================================================
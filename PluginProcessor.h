@@ -2,39 +2,19 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_audio_utils/juce_audio_utils.h>
+#include <array>
+#include <type_traits>
 
-// These custom oscillator types implement the anti-aliased saw/pulse algorithms required by the assignment.
+#include "AnalyserTap.h"
+#include "AudioThreadInstrumentation.h"
+#include "Decimator.h"
+#include "MultiTimbralParts.h"
+#include "PresetBank.h"
+#include "SynthVoice.h"
 
-//==============================================================================
-class AntiAliasedSawOscillator final
-{
-public:
-    void setFrequency (float newFrequency, double newSampleRate) noexcept;
-    float getNextSample() noexcept;
-    void reset() noexcept;
-
-private:
-    friend class AntiAliasedPulseOscillator;
-    float phase = 0.0f;
-    float osc = 0.0f;
-    float previousInput = 0.0f;
-    float w = 0.0f;
-    float beta = 0.0f;
-};
-
-class AntiAliasedPulseOscillator final
-{
-public:
-    void setFrequency (float newFrequency, double newSampleRate) noexcept;
-    void setPulseWidth (float newPulseWidth) noexcept;
-    float getNextSample() noexcept;
-    void reset() noexcept;
-
-private:
-    AntiAliasedSawOscillator leadingEdge;
-    AntiAliasedSawOscillator trailingEdge;
-    float pulseWidth = 0.5f;
-};
+#ifndef DPLUGIN_RENDER_WORKERS
+ #define DPLUGIN_RENDER_WORKERS 0
+#endif
 
 //==============================================================================
 class AudioPluginAudioProcessor final : public juce::AudioProcessor
@@ -50,8 +30,10 @@ public:
 
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
+    // Both precisions run the same templated path; a double host gets double output without a conversion pass.
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-    using AudioProcessor::processBlock;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -82,12 +64,139 @@ public:
     float getPulseWidth() const noexcept;
     float getFilterCutoff() const noexcept;
 
+    // Voice-bank mode steps all active voices together in SIMD lanes; the scalar per-voice path stays available for comparison.
+    void setVoiceBankEnabled (bool shouldBeEnabled) noexcept { synth.setVoiceBankEnabled (shouldBeEnabled); }
+    bool isVoiceBankEnabled() const noexcept                 { return synth.isVoiceBankEnabled(); }
+
+    // Voices outside the bank run fused gain/filter/mix kernels; the separate passes stay available for comparison.
+    void setFusedKernelsEnabled (bool shouldBeEnabled) noexcept { synth.setFusedKernelsEnabled (shouldBeEnabled); }
+    bool areFusedKernelsEnabled() const noexcept                { return synth.areFusedKernelsEnabled(); }
+
+    // Extra threads that render voices alongside the audio thread; applied at the next prepareToPlay().
+    void setNumRenderWorkers (int numWorkers) noexcept       { numRenderWorkers = juce::jmax (0, numWorkers); }
+    int getNumRenderWorkers() const noexcept                 { return numRenderWorkers; }
+
+    // Shortest run, in output samples, between two MIDI events that reach every voice (controllers, pitch wheel,
+    // pedals). Notes stay sample accurate, except one that follows such an event within the same run, which waits
+    // for it (see AntiAliasedSynthesiser::renderNextBlock()). Applied at the next prepareToPlay().
+    void setMinimumSubBlockSize (int numSamples) noexcept    { minimumSubBlockSize = juce::jmax (1, numSamples); }
+    int getMinimumSubBlockSize() const noexcept              { return minimumSubBlockSize; }
+
+    // The synth's own view, at the render rate: the minimum as applied at the last prepareToPlay(), and the shortest
+    // run a controller split has cut since then (0 while none has). For the scheduling test.
+    int getRenderMinimumSubBlockSize() const noexcept        { return synth.getMinimumSubBlockSize(); }
+    int getShortestControllerRun() const noexcept            { return synth.getShortestControllerRun(); }
+
+    // Audio-thread timing, summarised on the message thread for the editor and the optional log.
+    AudioThreadInstrumentation& getInstrumentation() noexcept { return instrumentation; }
+
+    // Output meters: while enabled (by an open editor) the audio thread keeps each main-bus channel's peak, which
+    // the editor reads and clears once per frame.
+    static constexpr int maxMeteredChannels = 2;
+    void setOutputMeteringEnabled (bool shouldBeEnabled) noexcept { outputMeteringEnabled.store (shouldBeEnabled); }
+    float getAndResetOutputPeak (int channel) noexcept;
+
+    // The finished output, for the editor's scope and spectrum; the editor switches it on while it is open.
+    AnalyserTap& getAnalyserTap() noexcept                   { return analyserTap; }
+
+    // How often the editor redraws its meters, in Hz; kept here so a reopened editor keeps the choice.
+    void setEditorRefreshRate (int framesPerSecond) noexcept { editorRefreshRate = juce::jlimit (1, 120, framesPerSecond); }
+    int getEditorRefreshRate() const noexcept                { return editorRefreshRate; }
+
+    // The Quality parameter: voices render at 1x, 2x or 4x the output rate and one decimator per output
+    // channel brings the mix back down.
+    enum class RenderQuality { draft, live, render };
+    static int getOversamplingFactor (RenderQuality quality) noexcept;
+    int getOversamplingFactor() const noexcept { return decimator.getFactor(); }
+
+    // Live playback uses the Quality parameter's factor with the float kernels. While the host renders offline
+    // (isNonRealtime()) the render engine takes over: 4x oversampling and double-precision oscillators and
+    // filters with std::sin. A change between the two is crossfaded over one block.
+    struct Engine
+    {
+        int oversamplingFactor = 1;
+        bool highPrecision = false;
+
+        bool operator== (const Engine& other) const noexcept { return oversamplingFactor == other.oversamplingFactor && highPrecision == other.highPrecision; }
+        bool operator!= (const Engine& other) const noexcept { return ! operator== (other); }
+    };
+
+    Engine getEngine() const noexcept { return currentEngine; }
+
 private:
     //==============================================================================
     juce::AudioProcessorValueTreeState parameters;                         // Hosts Gain/Pulse Width/Filter Cutoff parameters.
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    juce::Synthesiser synth;                                               // Manages AntiAliasedVoice instances for polyphony.
+    RenderQuality getRenderQuality() const noexcept;
+    Engine getTargetEngine() const noexcept;
+    void applyEngine (const Engine& engine) noexcept;
+    bool isIdle (const juce::MidiBuffer& midiMessages, int numSamples) noexcept;
+    void updateChannelRouting (bool multiTimbral) noexcept;
+    template <typename SampleType>
+    void updateOutputPeaks (const juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+    template <typename SampleType>
+    void switchEngine (const Engine& newEngine, juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages,
+                       AudioThreadInstrumentation::BlockScope& timing) noexcept;
+    template <typename SampleType>
+    void renderBlock (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages, int numSamples,
+                      AudioThreadInstrumentation::BlockScope& timing) noexcept;
+    template <typename SampleType>
+    void renderChunk (juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages, int numSamples,
+                      AudioThreadInstrumentation::BlockScope& timing) noexcept;
+    void copyChunkMidi (const juce::MidiBuffer& midiMessages, int start, int numSamples, int factor) noexcept;
+    template <typename SampleType>
+    void renderOversampled (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages, int numSamples,
+                            AudioThreadInstrumentation::BlockScope& timing) noexcept;
+
+    // Working buffers in the host's sample type. Both precisions are allocated, as the host may pick either.
+    template <typename SampleType>
+    struct RenderBuffers
+    {
+        juce::AudioBuffer<SampleType> oversampled;   // Voices render here while oversampling.
+        juce::AudioBuffer<SampleType> fade;          // The outgoing engine's block during a crossfade.
+        juce::AudioBuffer<SampleType> chunk;         // One chunk of a host block bigger than announced, at 1x.
+    };
+
+    template <typename SampleType>
+    RenderBuffers<SampleType>& getRenderBuffers() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleBuffers;
+        else
+            return floatBuffers;
+    }
+
+    static constexpr int maxPolyphony = 128;                               // Size of the voice pool allocated up front.
+    std::atomic<float>* polyphonyParam = nullptr;                          // Enabled voice count, applied at the start of each block.
+    std::atomic<float>* qualityParam = nullptr;                            // Render quality, applied at the start of each block.
+    std::atomic<float>* releaseParam = nullptr;                            // Envelope release time, reported as the tail length.
+    std::atomic<float>* voiceStealingParam = nullptr;                      // Steal the oldest or the quietest voice once all are busy.
+    std::atomic<float>* multiTimbralParam = nullptr;                       // One part per MIDI channel instead of one shared sound.
+    SmoothedParameters smoothedParameters;                                 // Per-block parameter ramps shared by every voice.
+    PresetBank presets;                                                    // Factory and user programs, applied by the audio thread.
+    MultiTimbralParts parts;                                               // Channels 2-16's own programs in multi-timbral mode.
+    std::array<AntiAliasedSynthesiser::ChannelRouting, MultiTimbralParts::numParts> partOutputs {};   // Each channel's output channels, from the bus layout.
+    juce::SharedResourcePointer<SharedTables> sharedTables;                // Process-wide tables, built once for every instance.
+    AntiAliasedSynthesiser synth;                                          // Manages AntiAliasedVoice instances for polyphony.
     double lastSampleRate = 44100.0;                                       // Cached sample rate for safety checks in processBlock().
+    int preparedBlockSize = 0;                                             // Host block size announced in prepareToPlay().
+    OversamplingDecimator decimator;                                       // One decimator chain per output channel, shared by all voices.
+    RenderBuffers<float> floatBuffers;                                     // Oversampling and crossfade buffers for float hosts.
+    RenderBuffers<double> doubleBuffers;                                   // The same for double-precision hosts.
+    juce::MidiBuffer oversampledMidi;                                      // One chunk's MIDI, timestamped from the chunk at the render rate.
+    Engine currentEngine;                                                  // Engine the voices and decimator are set up for.
+    juce::MidiBuffer noMidi;                                               // Stays empty; the outgoing engine sees no new events.
+    int numRenderWorkers = DPLUGIN_RENDER_WORKERS;                         // Worker threads for parallel voice rendering.
+    int minimumSubBlockSize = 32;                                          // Output samples between controller splits.
+    int settlingSamplesRemaining = 0;                                      // Decimator ringing still to render since the last voice.
+    AudioThreadInstrumentation instrumentation;                            // Per-block stage timings and overrun counters.
+    std::atomic<bool> outputMeteringEnabled { false };                     // Set while an editor shows the meters.
+    std::array<std::atomic<float>, maxMeteredChannels> outputPeaks {};     // Peaks since the editor last read them.
+    int editorRefreshRate = 30;                                            // Editor meter frames per second.
+    AnalyserTap analyserTap;                                               // Output samples for the editor's analyser.
     juce::MidiKeyboardState keyboardState;                                 // Captures events from the built-in MIDI keyboard component.
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessor)
 };
\ No newline at end of file
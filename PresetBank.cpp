@@ -0,0 +1,373 @@
+#include "PresetBank.h"
+#include "ParameterIDs.h"
+
+#include <algorithm>
+
+namespace
+{
+// Plain values, as the APVTS state stores them. A sound parameter a preset leaves out takes its default, so
+// Init is every default. filterCutoff runs from 0 = open to 1 = 200 Hz; filterType and oscillatorEngine are
+// choice indices.
+constexpr auto factoryPresets = R"(
+<Presets>
+  <Preset name="Init"/>
+  <Preset name="Soft Pad">
+    <PARAM id="gain" value="-15"/>
+    <PARAM id="filterCutoff" value="0.62"/>
+    <PARAM id="attack" value="0.8"/>
+    <PARAM id="decay" value="1.2"/>
+    <PARAM id="sustain" value="0.8"/>
+    <PARAM id="release" value="1.5"/>
+    <PARAM id="unisonVoices" value="4"/>
+    <PARAM id="unisonDetune" value="14"/>
+    <PARAM id="unisonSpread" value="0.8"/>
+  </Preset>
+  <Preset name="Bright Lead">
+    <PARAM id="pulseWidth" value="0.3"/>
+    <PARAM id="filterCutoff" value="0.15"/>
+    <PARAM id="attack" value="0.004"/>
+    <PARAM id="decay" value="0.3"/>
+    <PARAM id="sustain" value="0.7"/>
+    <PARAM id="release" value="0.12"/>
+    <PARAM id="unisonVoices" value="2"/>
+    <PARAM id="unisonDetune" value="8"/>
+  </Preset>
+  <Preset name="Pluck">
+    <PARAM id="pulseWidth" value="0.4"/>
+    <PARAM id="filterCutoff" value="0.45"/>
+    <PARAM id="attack" value="0.001"/>
+    <PARAM id="decay" value="0.25"/>
+    <PARAM id="sustain" value="0"/>
+    <PARAM id="release" value="0.2"/>
+  </Preset>
+  <Preset name="Hollow Square">
+    <PARAM id="gain" value="-14"/>
+    <PARAM id="filterCutoff" value="0.3"/>
+    <PARAM id="oscillatorEngine" value="1"/>
+    <PARAM id="release" value="0.3"/>
+  </Preset>
+  <Preset name="Thin Pulse">
+    <PARAM id="gain" value="-10"/>
+    <PARAM id="pulseWidth" value="0.08"/>
+    <PARAM id="filterCutoff" value="0.2"/>
+    <PARAM id="filterType" value="0"/>
+  </Preset>
+  <Preset name="Wide Stack">
+    <PARAM id="gain" value="-16"/>
+    <PARAM id="filterCutoff" value="0.25"/>
+    <PARAM id="oscillatorEngine" value="1"/>
+    <PARAM id="attack" value="0.02"/>
+    <PARAM id="release" value="0.6"/>
+    <PARAM id="unisonVoices" value="8"/>
+    <PARAM id="unisonDetune" value="35"/>
+    <PARAM id="unisonSpread" value="1"/>
+  </Preset>
+  <Preset name="Dark Bass">
+    <PARAM id="gain" value="-9"/>
+    <PARAM id="pulseWidth" value="0.35"/>
+    <PARAM id="filterCutoff" value="0.82"/>
+    <PARAM id="attack" value="0.001"/>
+    <PARAM id="decay" value="0.4"/>
+    <PARAM id="sustain" value="0.6"/>
+    <PARAM id="release" value="0.08"/>
+  </Preset>
+</Presets>
+)";
+
+constexpr const char* setupParameterIDs[] = { polyphonyParamID, qualityParamID, voiceStealingParamID, mpeBendRangeParamID,
+                                              multiTimbralParamID };
+constexpr auto presetFileExtension = ".xml";
+constexpr int fallbackTicks = 3;   // Timer ticks a program may wait for the audio thread before the timer applies it.
+}
+
+//==============================================================================
+// Parses whenever asked to, and once at the start.
+class PresetBank::Loader final : public juce::Thread
+{
+public:
+    explicit Loader (PresetBank& ownerBank)
+        : juce::Thread ("DPlugin preset loader"), owner (ownerBank)
+    {
+    }
+
+    void requestLoad() noexcept
+    {
+        loadRequested.store (true);
+        notify();
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (loadRequested.exchange (false))
+                owner.publish (owner.loadSnapshot());
+
+            wait (-1);
+        }
+    }
+
+private:
+    PresetBank& owner;
+    std::atomic<bool> loadRequested { true };
+};
+
+//==============================================================================
+PresetBank::PresetBank (juce::AudioProcessorValueTreeState& parameterState)
+    : state (parameterState)
+{
+    for (auto* parameter : state.processor.getParameters())
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter);
+
+        if (ranged == nullptr || std::any_of (std::begin (setupParameterIDs), std::end (setupParameterIDs),
+                                              [&] (const char* id) { return ranged->paramID == id; }))
+            continue;
+
+        targets.push_back ({ ranged, state.getRawParameterValue (ranged->paramID) });
+    }
+
+    loader = std::make_unique<Loader> (*this);
+
+    // Without a thread to spare, the bank is parsed in place; it is a few small XML documents.
+    if (! loader->startThread())
+        publish (loadSnapshot());
+
+    startTimerHz (20);
+}
+
+PresetBank::~PresetBank()
+{
+    stopTimer();
+    loader->signalThreadShouldExit();
+    loader->notify();
+    loader->stopThread (-1);
+    delete current.exchange (nullptr);
+}
+
+juce::File PresetBank::getUserPresetDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile (JucePlugin_Name)
+               .getChildFile ("Presets");
+}
+
+//==============================================================================
+std::unique_ptr<PresetBank::Snapshot> PresetBank::loadSnapshot() const
+{
+    auto snapshot = std::make_unique<Snapshot>();
+
+    if (const auto factory = juce::parseXML (factoryPresets))
+        for (const auto* preset : factory->getChildIterator())
+            addPreset (*snapshot, *preset, {});
+
+    // User presets follow the factory ones, so the factory program numbers never move.
+    auto files = getUserPresetDirectory().findChildFiles (juce::File::findFiles, false, juce::String ("*") + presetFileExtension);
+    std::sort (files.begin(), files.end(), [] (const juce::File& a, const juce::File& b) { return a.getFileName() < b.getFileName(); });
+
+    for (const auto& file : files)
+        if (const auto xml = juce::parseXML (file))
+            addPreset (*snapshot, *xml, file.getFileNameWithoutExtension());
+
+    return snapshot;
+}
+
+// A preset is any element with APVTS-style PARAM children, so a saved parameter tree also loads as one.
+void PresetBank::addPreset (Snapshot& snapshot, const juce::XmlElement& xml, const juce::String& fallbackName) const
+{
+    Preset preset;
+    preset.name = xml.getStringAttribute ("name", fallbackName);
+    preset.values.reserve (targets.size());
+
+    for (const auto& target : targets)
+        preset.values.push_back (target.parameter->convertFrom0to1 (target.parameter->getDefaultValue()));
+
+    for (const auto* child : xml.getChildWithTagNameIterator ("PARAM"))
+    {
+        const auto id = child->getStringAttribute ("id");
+
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            if (targets[i].parameter->paramID != id)
+                continue;
+
+            // Through the normalised range, so an out-of-range or off-step value lands on a legal one.
+            const auto& parameter = *targets[i].parameter;
+            const auto value = static_cast<float> (child->getDoubleAttribute ("value", preset.values[i]));
+            preset.values[i] = parameter.convertFrom0to1 (parameter.convertTo0to1 (value));
+        }
+    }
+
+    if (preset.name.isEmpty())
+        preset.name = "Preset " + juce::String (static_cast<int> (snapshot.presets.size()) + 1);
+
+    snapshot.presets.push_back (std::move (preset));
+}
+
+// Loader thread, or the constructor.
+void PresetBank::publish (std::unique_ptr<Snapshot> snapshot)
+{
+    if (auto* previous = current.exchange (snapshot.release()))
+    {
+        const juce::ScopedLock sl (retiredLock);
+        retired.emplace_back (previous);
+    }
+
+    loaded.signal();
+}
+
+// Message thread: nothing frees the current snapshot here while it is being read.
+const PresetBank::Snapshot* PresetBank::waitForSnapshot() const
+{
+    loaded.wait (1000.0);
+    return current.load();
+}
+
+int PresetBank::getNumPrograms() const
+{
+    const auto* snapshot = waitForSnapshot();
+    return snapshot != nullptr ? juce::jmax (1, static_cast<int> (snapshot->presets.size())) : 1;
+}
+
+juce::String PresetBank::getProgramName (int index) const
+{
+    const auto* snapshot = waitForSnapshot();
+
+    if (snapshot == nullptr || ! juce::isPositiveAndBelow (index, static_cast<int> (snapshot->presets.size())))
+        return {};
+
+    return snapshot->presets[static_cast<size_t> (index)].name;
+}
+
+void PresetBank::rescan()
+{
+    loader->requestLoad();
+}
+
+bool PresetBank::saveUserPreset (const juce::String& name)
+{
+    auto xml = state.copyState().createXml();
+
+    if (xml == nullptr || name.trim().isEmpty())
+        return false;
+
+    xml->setTagName ("Preset");
+    xml->setAttribute ("name", name.trim());
+
+    const auto directory = getUserPresetDirectory();
+
+    if (! directory.createDirectory())
+        return false;
+
+    if (! xml->writeTo (directory.getChildFile (juce::File::createLegalFileName (name.trim()) + presetFileExtension)))
+        return false;
+
+    rescan();
+    return true;
+}
+
+//==============================================================================
+void PresetBank::selectProgram (int index) noexcept
+{
+    currentProgram.store (index);
+    pendingProgram.store (index);
+}
+
+bool PresetBank::applyPendingProgram() noexcept
+{
+    const auto index = pendingProgram.exchange (-1);
+
+    if (index < 0)
+        return false;
+
+    const auto* snapshot = acquireSnapshot();
+
+    if (snapshot != nullptr)
+        applyProgram (*snapshot, index);
+
+    releaseSnapshot();
+    return snapshot != nullptr;
+}
+
+bool PresetBank::copyProgram (int index, std::atomic<float>* destination) noexcept
+{
+    const auto* snapshot = acquireSnapshot();
+    const auto exists = snapshot != nullptr && juce::isPositiveAndBelow (index, static_cast<int> (snapshot->presets.size()));
+
+    if (exists)
+    {
+        const auto& values = snapshot->presets[static_cast<size_t> (index)].values;
+
+        for (size_t i = 0; i < values.size(); ++i)
+            destination[i].store (values[i]);
+    }
+
+    releaseSnapshot();
+    return exists;
+}
+
+int PresetBank::indexOfSoundParameter (const juce::String& parameterID) const noexcept
+{
+    for (size_t i = 0; i < targets.size(); ++i)
+        if (targets[i].parameter->paramID == parameterID)
+            return static_cast<int> (i);
+
+    return -1;
+}
+
+// Audio thread. Published as in use before it is read; a snapshot swapped out in between is retried, not read.
+const PresetBank::Snapshot* PresetBank::acquireSnapshot() noexcept
+{
+    const Snapshot* snapshot = current.load();
+
+    for (;;)
+    {
+        hazard.store (snapshot);
+        const Snapshot* check = current.load();
+
+        if (check == snapshot)
+            return snapshot;
+
+        snapshot = check;
+    }
+}
+
+void PresetBank::applyProgram (const Snapshot& snapshot, int index) noexcept
+{
+    if (! juce::isPositiveAndBelow (index, static_cast<int> (snapshot.presets.size())))
+        return;
+
+    const auto& values = snapshot.presets[static_cast<size_t> (index)].values;
+
+    for (size_t i = 0; i < targets.size(); ++i)
+        if (targets[i].value != nullptr)
+            targets[i].value->store (values[i]);
+
+    needsHostUpdate.store (true);
+}
+
+// Frees what the audio thread has let go of, applies a program the audio thread hasn't picked up (it may not be
+// running), and hands applied values to the parameters, which notify the host, the editor and the state tree.
+void PresetBank::timerCallback()
+{
+    {
+        const juce::ScopedLock sl (retiredLock);
+        const auto* inUse = hazard.load();
+        retired.erase (std::remove_if (retired.begin(), retired.end(), [inUse] (const auto& s) { return s.get() != inUse; }),
+                       retired.end());
+    }
+
+    if (pendingProgram.load() < 0)
+        ticksPending = 0;
+    else if (++ticksPending >= fallbackTicks)
+        if (const auto index = pendingProgram.exchange (-1); index >= 0)
+            if (const auto* snapshot = current.load())
+                applyProgram (*snapshot, index);
+
+    if (! needsHostUpdate.exchange (false))
+        return;
+
+    for (const auto& target : targets)
+        if (target.value != nullptr)
+            target.parameter->setValueNotifyingHost (target.parameter->convertTo0to1 (target.value->load()));
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// The processor's programs: the factory presets, then the user's preset files. A background thread parses them
+// into an immutable Snapshot and publishes it with one pointer swap; a replaced snapshot is freed on the message
+// thread once the audio thread is no longer reading it (a single hazard pointer, as there is one audio thread).
+//
+// Programs set the sound parameters only; polyphony, quality, voice stealing, the MPE bend range and the
+// multi-timbral switch belong to the setup and stay as they are. A program change is queued and the audio
+// thread takes it at the start of its next block by writing the preset's values into the parameters' raw
+// values, so the smoothed parameters glide to them like any other change, with no lock or allocation. A timer
+// then tells the host and editor.
+class PresetBank final : private juce::Timer
+{
+public:
+    explicit PresetBank (juce::AudioProcessorValueTreeState& parameterState);
+    ~PresetBank() override;
+
+    // Message thread. The first calls wait for the first parse, which the constructor starts.
+    int getNumPrograms() const;   // At least 1, as hosts expect.
+    juce::String getProgramName (int index) const;
+
+    // Message thread. Both reparse in the background; the current program keeps playing meanwhile.
+    void rescan();
+    bool saveUserPreset (const juce::String& name);   // The current sound parameters, as a user preset file.
+    static juce::File getUserPresetDirectory();
+
+    // Any thread, the audio thread included.
+    void selectProgram (int index) noexcept;
+    int getCurrentProgram() const noexcept                   { return currentProgram.load(); }
+
+    // Audio thread, before the block's parameters are smoothed. Returns true when a program was applied.
+    bool applyPendingProgram() noexcept;
+
+    // The sound parameters programs set, in the order copyProgram() writes them.
+    int getNumSoundParameters() const noexcept               { return static_cast<int> (targets.size()); }
+    int indexOfSoundParameter (const juce::String& parameterID) const noexcept;   // -1 for a setup parameter.
+
+    bool hasPrograms() const noexcept                        { return current.load() != nullptr; }   // False until the first parse.
+
+    // Audio thread: writes a program's values, one per sound parameter, somewhere other than the parameters
+    // (a multi-timbral part's own set). Returns false, writing nothing, for a program that doesn't exist.
+    bool copyProgram (int index, std::atomic<float>* destination) noexcept;
+
+private:
+    struct Preset
+    {
+        juce::String name;
+        std::vector<float> values;   // Plain values, one per target.
+    };
+
+    struct Snapshot
+    {
+        std::vector<Preset> presets;
+    };
+
+    struct Target
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        std::atomic<float>* value = nullptr;   // The APVTS raw value the DSP reads.
+    };
+
+    class Loader;
+
+    void timerCallback() override;
+    std::unique_ptr<Snapshot> loadSnapshot() const;
+    void addPreset (Snapshot& snapshot, const juce::XmlElement& xml, const juce::String& fallbackName) const;
+    void publish (std::unique_ptr<Snapshot> snapshot);
+    const Snapshot* waitForSnapshot() const;
+    const Snapshot* acquireSnapshot() noexcept;
+    void releaseSnapshot() noexcept                          { hazard.store (nullptr); }
+    void applyProgram (const Snapshot& snapshot, int index) noexcept;
+
+    juce::AudioProcessorValueTreeState& state;
+    std::vector<Target> targets;
+    std::atomic<Snapshot*> current { nullptr };
+    std::atomic<const Snapshot*> hazard { nullptr };   // The snapshot the audio thread is reading, if any.
+    std::vector<std::unique_ptr<Snapshot>> retired;    // Replaced snapshots, freed by timerCallback().
+    juce::CriticalSection retiredLock;                 // Between the loader and the message thread only.
+    juce::WaitableEvent loaded { true };
+    std::atomic<int> pendingProgram { -1 };
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<bool> needsHostUpdate { false };
+    int ticksPending = 0;
+    std::unique_ptr<Loader> loader;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetBank)
+};
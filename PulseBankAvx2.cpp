@@ -0,0 +1,57 @@
+#include "PulseBankKernels.h"
+
+// Built with AVX2 enabled where CMakeLists.txt knows how to; everything here is local to this translation unit.
+#if defined (__AVX2__) && DPLUGIN_SINE_KERNEL == DPLUGIN_SINE_KERNEL_POLYNOMIAL
+
+#include <cstddef>
+#include <immintrin.h>
+
+namespace
+{
+    // Eight float lanes with the SIMDRegister interface PulseBankRenderer expects; masks are all-ones lanes, as
+    // with JUCE's SSE and NEON registers.
+    struct Avx2Lanes
+    {
+        static constexpr size_t SIMDNumElements = 8;
+
+        static Avx2Lanes expand (float value) noexcept           { return { _mm256_set1_ps (value) }; }
+        static Avx2Lanes fromRawArray (const float* a) noexcept  { return { _mm256_load_ps (a) }; }
+        void copyToRawArray (float* a) const noexcept            { _mm256_store_ps (a, value); }
+
+        Avx2Lanes operator+ (Avx2Lanes other) const noexcept     { return { _mm256_add_ps (value, other.value) }; }
+        Avx2Lanes operator- (Avx2Lanes other) const noexcept     { return { _mm256_sub_ps (value, other.value) }; }
+        Avx2Lanes operator* (Avx2Lanes other) const noexcept     { return { _mm256_mul_ps (value, other.value) }; }
+        Avx2Lanes operator& (Avx2Lanes mask) const noexcept      { return { _mm256_and_ps (value, mask.value) }; }
+
+        static Avx2Lanes min (Avx2Lanes a, Avx2Lanes b) noexcept { return { _mm256_min_ps (a.value, b.value) }; }
+        static Avx2Lanes max (Avx2Lanes a, Avx2Lanes b) noexcept { return { _mm256_max_ps (a.value, b.value) }; }
+        static Avx2Lanes abs (Avx2Lanes a) noexcept              { return { _mm256_andnot_ps (_mm256_set1_ps (-0.0f), a.value) }; }
+
+        // Through int32, as JUCE's registers truncate; phases stay far inside that range.
+        static Avx2Lanes truncate (Avx2Lanes a) noexcept         { return { _mm256_cvtepi32_ps (_mm256_cvttps_epi32 (a.value)) }; }
+
+        static Avx2Lanes greaterThan (Avx2Lanes a, Avx2Lanes b) noexcept        { return { _mm256_cmp_ps (a.value, b.value, _CMP_GT_OQ) }; }
+        static Avx2Lanes greaterThanOrEqual (Avx2Lanes a, Avx2Lanes b) noexcept { return { _mm256_cmp_ps (a.value, b.value, _CMP_GE_OQ) }; }
+        static Avx2Lanes lessThan (Avx2Lanes a, Avx2Lanes b) noexcept           { return { _mm256_cmp_ps (a.value, b.value, _CMP_LT_OQ) }; }
+
+        __m256 value;
+    };
+
+    using Avx2Renderer = PulseBankRenderer<Avx2Lanes, PolynomialSine>;
+
+    constexpr PulseBankKernels avx2Kernels { &Avx2Renderer::processBiquad, &Avx2Renderer::processSvf, &Avx2Renderer::processUnison };
+}
+
+const PulseBankKernels* getPulseBankAvx2Kernels() noexcept
+{
+    return &avx2Kernels;
+}
+
+#else
+
+const PulseBankKernels* getPulseBankAvx2Kernels() noexcept
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "PulseBankKernels.h"
+
+// Built with AVX-512F enabled where CMakeLists.txt knows how to; everything here is local to this translation unit.
+#if defined (__AVX512F__) && DPLUGIN_SINE_KERNEL == DPLUGIN_SINE_KERNEL_POLYNOMIAL
+
+#include <cstddef>
+
+// GCC 12's AVX-512 intrinsics seed their unused pass-through operand from an uninitialised variable.
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC diagnostic push
+ #pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+
+#include <immintrin.h>
+
+#if defined (__GNUC__) && ! defined (__clang__)
+ #pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+    // AVX-512 comparisons produce a mask register rather than all-ones lanes; & with one zeroes the unset lanes.
+    struct Avx512Mask
+    {
+        __mmask16 bits;
+    };
+
+    // Sixteen float lanes with the SIMDRegister interface PulseBankRenderer expects.
+    struct Avx512Lanes
+    {
+        static constexpr size_t SIMDNumElements = 16;
+
+        static Avx512Lanes expand (float value) noexcept             { return { _mm512_set1_ps (value) }; }
+        static Avx512Lanes fromRawArray (const float* a) noexcept    { return { _mm512_load_ps (a) }; }
+        void copyToRawArray (float* a) const noexcept                { _mm512_store_ps (a, value); }
+
+        Avx512Lanes operator+ (Avx512Lanes other) const noexcept     { return { _mm512_add_ps (value, other.value) }; }
+        Avx512Lanes operator- (Avx512Lanes other) const noexcept     { return { _mm512_sub_ps (value, other.value) }; }
+        Avx512Lanes operator* (Avx512Lanes other) const noexcept     { return { _mm512_mul_ps (value, other.value) }; }
+        Avx512Lanes operator& (Avx512Mask mask) const noexcept       { return { _mm512_maskz_mov_ps (mask.bits, value) }; }
+
+        static Avx512Lanes min (Avx512Lanes a, Avx512Lanes b) noexcept { return { _mm512_min_ps (a.value, b.value) }; }
+        static Avx512Lanes max (Avx512Lanes a, Avx512Lanes b) noexcept { return { _mm512_max_ps (a.value, b.value) }; }
+        static Avx512Lanes abs (Avx512Lanes a) noexcept                { return { _mm512_abs_ps (a.value) }; }
+
+        // Through int32, as JUCE's registers truncate; phases stay far inside that range.
+        static Avx512Lanes truncate (Avx512Lanes a) noexcept           { return { _mm512_cvtepi32_ps (_mm512_cvttps_epi32 (a.value)) }; }
+
+        static Avx512Mask greaterThan (Avx512Lanes a, Avx512Lanes b) noexcept        { return { _mm512_cmp_ps_mask (a.value, b.value, _CMP_GT_OQ) }; }
+        static Avx512Mask greaterThanOrEqual (Avx512Lanes a, Avx512Lanes b) noexcept { return { _mm512_cmp_ps_mask (a.value, b.value, _CMP_GE_OQ) }; }
+        static Avx512Mask lessThan (Avx512Lanes a, Avx512Lanes b) noexcept           { return { _mm512_cmp_ps_mask (a.value, b.value, _CMP_LT_OQ) }; }
+
+        __m512 value;
+    };
+
+    using Avx512Renderer = PulseBankRenderer<Avx512Lanes, PolynomialSine>;
+
+    constexpr PulseBankKernels avx512Kernels { &Avx512Renderer::processBiquad, &Avx512Renderer::processSvf, &Avx512Renderer::processUnison };
+}
+
+const PulseBankKernels* getPulseBankAvx512Kernels() noexcept
+{
+    return &avx512Kernels;
+}
+
+#else
+
+const PulseBankKernels* getPulseBankAvx512Kernels() noexcept
+{
+    return nullptr;
+}
+
+#endif
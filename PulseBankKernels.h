@@ -0,0 +1,312 @@
+#pragma once
+
+#include "PulseKernels.h"
+
+//==============================================================================
+// PulseVoiceBank's render kernels. They are built once at the baseline instruction set with juce::dsp::SIMDRegister
+// and again in PulseBankAvx2.cpp and PulseBankAvx512.cpp, whose translation units are compiled for those sets and
+// bring their own lane types; PulseVoiceBank picks one table per process when the CPU's features are known, and
+// UnisonOscillator steps its layers through the same table. Only these lane kernels are dispatched: a voice's own
+// oscillator, filter and gain run one sample after another through recursions a wider register can't split, so
+// they, and SmoothedParameters::applyGain(), stay at the baseline, as does everything on ARM64, whose baseline is
+// already NEON.
+// This header, like PulseKernels.h, must stay free of JUCE: anything inline it pulls into those translation units
+// would be compiled for the wider set, and the linker could then hand that copy to baseline code.
+
+// Structure-of-arrays state of up to numLanes voices, or of one unison stack's layers. The group is as wide as the
+// widest kernel's register; narrower kernels step it a register at a time, which adds every lane to the mix in the
+// same order.
+struct alignas (64) PulseBankGroup
+{
+    static constexpr int numLanes = 16;
+
+    float leadingPhase[numLanes], leadingOsc[numLanes], leadingPrevious[numLanes];
+    float trailingPhase[numLanes], trailingOsc[numLanes], trailingPrevious[numLanes];
+    float w[numLanes], beta[numLanes], dc[numLanes], inverseNorm[numLanes], pulseWidth[numLanes];
+    float level[numLanes];
+    float rightLevel[numLanes];   // Unison only: each layer's gain into the right channel, with level as its left.
+    float b0[numLanes], b1[numLanes], b2[numLanes], a1[numLanes], a2[numLanes];
+    float z1[numLanes], z2[numLanes];   // Biquad state, or the SVF's ic1eq/ic2eq.
+};
+
+// One instruction set's kernels: the bank's with PulseVoiceBank::process()'s arguments, and the unison stack's.
+struct PulseBankKernels
+{
+    using BiquadKernel = void (*) (PulseBankGroup* groups, int numVoices, float* mix, const float* pulseWidths,
+                                   int numSamples) noexcept;
+    using SvfKernel = void (*) (PulseBankGroup* groups, int numVoices, float* mix, const float* pulseWidths,
+                                const SvfCoefficients& coefficients, const SvfCoefficients* coefficientRamp,
+                                int numSamples) noexcept;
+    using UnisonKernel = void (*) (PulseBankGroup& layers, int numLayers, float* left, float* right, const float* pulseWidths,
+                                   int numSamples) noexcept;
+
+    BiquadKernel biquad;
+    SvfKernel svf;
+    UnisonKernel unison;
+};
+
+// The table PulseVoiceBank chose for this process, or was told to use; see PulseVoiceBank::setInstructionSet().
+// The first call makes the choice, which PulseVoiceBank::prepare() does before anything renders.
+const PulseBankKernels& getActivePulseBankKernels() noexcept;
+
+// Null when the build didn't enable the instruction set, or the sine kernel isn't the polynomial one (the others
+// need JUCE or libm per lane). Their code may use the instruction set anywhere, so only call these once the CPU is
+// known to support it.
+const PulseBankKernels* getPulseBankAvx2Kernels() noexcept;
+const PulseBankKernels* getPulseBankAvx512Kernels() noexcept;
+
+//==============================================================================
+// The kernels for one lane type: BasicPulseLanes followed by each voice's filter, one register of lanes at a time.
+// Instantiate it only with types local to the translation unit, or with the baseline ones.
+template <typename Lanes, typename Sine>
+struct PulseBankRenderer final
+{
+    static constexpr int laneCount = static_cast<int> (Lanes::SIMDNumElements);
+    static_assert (PulseBankGroup::numLanes % laneCount == 0, "a register must not straddle two groups");
+
+    static void processBiquad (PulseBankGroup* groups, int numVoices, float* mix, const float* pulseWidths,
+                               int numSamples) noexcept
+    {
+        if (pulseWidths != nullptr)
+            render<true> (groups, numVoices, mix, pulseWidths, BiquadLanes {}, numSamples);
+        else
+            render<false> (groups, numVoices, mix, nullptr, BiquadLanes {}, numSamples);
+    }
+
+    static void processSvf (PulseBankGroup* groups, int numVoices, float* mix, const float* pulseWidths,
+                            const SvfCoefficients& coefficients, const SvfCoefficients* coefficientRamp,
+                            int numSamples) noexcept
+    {
+        if (coefficientRamp != nullptr)
+        {
+            const SvfLanes<true> filter (coefficients, coefficientRamp);
+
+            if (pulseWidths != nullptr)
+                render<true> (groups, numVoices, mix, pulseWidths, filter, numSamples);
+            else
+                render<false> (groups, numVoices, mix, nullptr, filter, numSamples);
+        }
+        else
+        {
+            const SvfLanes<false> filter (coefficients, nullptr);
+
+            if (pulseWidths != nullptr)
+                render<true> (groups, numVoices, mix, pulseWidths, filter, numSamples);
+            else
+                render<false> (groups, numVoices, mix, nullptr, filter, numSamples);
+        }
+    }
+
+    // UnisonOscillator's stack: the first numLayers lanes of one group, unfiltered, each added to left at its level
+    // and, when right is non-null, to right at its rightLevel. Layers are added in order at every width.
+    static void processUnison (PulseBankGroup& layers, int numLayers, float* left, float* right, const float* pulseWidths,
+                               int numSamples) noexcept
+    {
+        if (pulseWidths != nullptr)
+        {
+            if (right != nullptr)
+                renderUnison<true, true> (layers, numLayers, left, right, pulseWidths, numSamples);
+            else
+                renderUnison<true, false> (layers, numLayers, left, nullptr, pulseWidths, numSamples);
+        }
+        else
+        {
+            if (right != nullptr)
+                renderUnison<false, true> (layers, numLayers, left, right, nullptr, numSamples);
+            else
+                renderUnison<false, false> (layers, numLayers, left, nullptr, nullptr, numSamples);
+        }
+    }
+
+private:
+    // Lane-for-lane transcription of LowPassBiquad::processSample(), with per-lane coefficients.
+    struct BiquadLanes
+    {
+        void load (const PulseBankGroup& group, int offset) noexcept
+        {
+            b0 = Lanes::fromRawArray (group.b0 + offset);
+            b1 = Lanes::fromRawArray (group.b1 + offset);
+            b2 = Lanes::fromRawArray (group.b2 + offset);
+            a1 = Lanes::fromRawArray (group.a1 + offset);
+            a2 = Lanes::fromRawArray (group.a2 + offset);
+            z1 = Lanes::fromRawArray (group.z1 + offset);
+            z2 = Lanes::fromRawArray (group.z2 + offset);
+        }
+
+        Lanes process (Lanes input, int) noexcept
+        {
+            const auto output = (b0 * input) + z1;
+            z1 = ((b1 * input) - (a1 * output)) + z2;
+            z2 = (b2 * input) - (a2 * output);
+            return output;
+        }
+
+        void save (PulseBankGroup& group, int offset) const noexcept
+        {
+            z1.copyToRawArray (group.z1 + offset);
+            z2.copyToRawArray (group.z2 + offset);
+        }
+
+        Lanes b0, b1, b2, a1, a2, z1, z2;
+    };
+
+    // Lane-for-lane transcription of LowPassSvf's tick, with coefficients shared by every lane.
+    template <bool hasCoefficientRamp>
+    struct SvfLanes
+    {
+        SvfLanes (const SvfCoefficients& coefficients, const SvfCoefficients* rampToUse) noexcept
+            : a1 (Lanes::expand (coefficients.a1)),
+              a2 (Lanes::expand (coefficients.a2)),
+              a3 (Lanes::expand (coefficients.a3)),
+              ramp (rampToUse)
+        {
+        }
+
+        void load (const PulseBankGroup& group, int offset) noexcept
+        {
+            ic1 = Lanes::fromRawArray (group.z1 + offset);
+            ic2 = Lanes::fromRawArray (group.z2 + offset);
+        }
+
+        Lanes process (Lanes input, int sample) noexcept
+        {
+            if constexpr (hasCoefficientRamp)
+            {
+                a1 = Lanes::expand (ramp[sample].a1);
+                a2 = Lanes::expand (ramp[sample].a2);
+                a3 = Lanes::expand (ramp[sample].a3);
+            }
+
+            const auto v3 = input - ic2;
+            const auto v1 = (a1 * ic1) + (a2 * v3);
+            const auto v2 = (ic2 + (a2 * ic1)) + (a3 * v3);
+            ic1 = (two * v1) - ic1;
+            ic2 = (two * v2) - ic2;
+            return v2;
+        }
+
+        void save (PulseBankGroup& group, int offset) const noexcept
+        {
+            ic1.copyToRawArray (group.z1 + offset);
+            ic2.copyToRawArray (group.z2 + offset);
+        }
+
+        Lanes a1, a2, a3, ic1, ic2;
+        const Lanes two = Lanes::expand (2.0f);
+        const SvfCoefficients* ramp;
+    };
+
+    // The width clamp is juce::jlimit (0.01f, 0.99f, width), spelled out to keep JUCE out of this header.
+    template <bool hasWidthRamp>
+    static Lanes widthAt (const float* pulseWidths, Lanes constantWidth, int sample) noexcept
+    {
+        if constexpr (hasWidthRamp)
+        {
+            const auto width = pulseWidths[sample];
+            return Lanes::expand (width < 0.01f ? 0.01f : (0.99f < width ? 0.99f : width));
+        }
+        else
+        {
+            return constantWidth;
+        }
+    }
+
+    static void loadOscillators (BasicPulseLanes<Lanes, Sine>& oscillators, const PulseBankGroup& group, int offset) noexcept
+    {
+        oscillators.leadingPhase = Lanes::fromRawArray (group.leadingPhase + offset);
+        oscillators.leadingOsc = Lanes::fromRawArray (group.leadingOsc + offset);
+        oscillators.leadingPrevious = Lanes::fromRawArray (group.leadingPrevious + offset);
+        oscillators.trailingPhase = Lanes::fromRawArray (group.trailingPhase + offset);
+        oscillators.trailingOsc = Lanes::fromRawArray (group.trailingOsc + offset);
+        oscillators.trailingPrevious = Lanes::fromRawArray (group.trailingPrevious + offset);
+        oscillators.w = Lanes::fromRawArray (group.w + offset);
+        oscillators.beta = Lanes::fromRawArray (group.beta + offset);
+        oscillators.dc = Lanes::fromRawArray (group.dc + offset);
+        oscillators.inverseNorm = Lanes::fromRawArray (group.inverseNorm + offset);
+    }
+
+    static void saveOscillators (const BasicPulseLanes<Lanes, Sine>& oscillators, PulseBankGroup& group, int offset) noexcept
+    {
+        oscillators.leadingPhase.copyToRawArray (group.leadingPhase + offset);
+        oscillators.leadingOsc.copyToRawArray (group.leadingOsc + offset);
+        oscillators.leadingPrevious.copyToRawArray (group.leadingPrevious + offset);
+        oscillators.trailingPhase.copyToRawArray (group.trailingPhase + offset);
+        oscillators.trailingOsc.copyToRawArray (group.trailingOsc + offset);
+        oscillators.trailingPrevious.copyToRawArray (group.trailingPrevious + offset);
+    }
+
+    template <bool hasWidthRamp, typename LaneFilter>
+    static void render (PulseBankGroup* groups, int numVoices, float* mix, const float* pulseWidths, LaneFilter filter,
+                        int numSamples) noexcept
+    {
+        alignas (64) float outputs[Lanes::SIMDNumElements];
+        BasicPulseLanes<Lanes, Sine> oscillators;
+
+        for (int first = 0; first < numVoices; first += laneCount)
+        {
+            auto& group = groups[first / PulseBankGroup::numLanes];
+            const auto offset = first % PulseBankGroup::numLanes;
+            const auto lanesInUse = numVoices - first < laneCount ? numVoices - first : laneCount;
+
+            loadOscillators (oscillators, group, offset);
+            filter.load (group, offset);
+
+            const auto constantWidth = Lanes::fromRawArray (group.pulseWidth + offset);
+            const auto level = Lanes::fromRawArray (group.level + offset);
+
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                const auto pulse = oscillators.step (widthAt<hasWidthRamp> (pulseWidths, constantWidth, sample));
+                const auto output = filter.process (pulse * level, sample);
+
+                output.copyToRawArray (outputs);
+
+                for (int lane = 0; lane < lanesInUse; ++lane)
+                    mix[sample] += outputs[lane];
+            }
+
+            saveOscillators (oscillators, group, offset);
+            filter.save (group, offset);
+        }
+    }
+
+    template <bool hasWidthRamp, bool isStereoMix>
+    static void renderUnison (PulseBankGroup& layers, int numLayers, float* left, float* right, const float* pulseWidths,
+                              int numSamples) noexcept
+    {
+        alignas (64) float leftOutputs[Lanes::SIMDNumElements];
+        alignas (64) float rightOutputs[Lanes::SIMDNumElements];
+        BasicPulseLanes<Lanes, Sine> oscillators;
+
+        for (int offset = 0; offset < numLayers; offset += laneCount)
+        {
+            const auto lanesInUse = numLayers - offset < laneCount ? numLayers - offset : laneCount;
+
+            loadOscillators (oscillators, layers, offset);
+
+            const auto constantWidth = Lanes::fromRawArray (layers.pulseWidth + offset);
+            const auto leftLevel = Lanes::fromRawArray (layers.level + offset);
+            const auto rightLevel = Lanes::fromRawArray (layers.rightLevel + offset);
+
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                const auto pulse = oscillators.step (widthAt<hasWidthRamp> (pulseWidths, constantWidth, sample));
+
+                (pulse * leftLevel).copyToRawArray (leftOutputs);
+
+                for (int lane = 0; lane < lanesInUse; ++lane)
+                    left[sample] += leftOutputs[lane];
+
+                if constexpr (isStereoMix)
+                {
+                    (pulse * rightLevel).copyToRawArray (rightOutputs);
+
+                    for (int lane = 0; lane < lanesInUse; ++lane)
+                        right[sample] += rightOutputs[lane];
+                }
+            }
+
+            saveOscillators (oscillators, layers, offset);
+        }
+    }
+};
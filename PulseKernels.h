@@ -0,0 +1,118 @@
+#pragma once
+
+// Sine kernels selectable at compile time through DPLUGIN_SINE_KERNEL (see CMakeLists.txt).
+#define DPLUGIN_SINE_KERNEL_STD        0
+#define DPLUGIN_SINE_KERNEL_TABLE      1
+#define DPLUGIN_SINE_KERNEL_POLYNOMIAL 2
+
+#ifndef DPLUGIN_SINE_KERNEL
+ #define DPLUGIN_SINE_KERNEL DPLUGIN_SINE_KERNEL_POLYNOMIAL
+#endif
+
+//==============================================================================
+// The pulse oscillator's lane maths, free of JUCE so the voice bank's wider instruction-set variants (see
+// PulseBankKernels.h) can compile it without building any JUCE code for a target the rest of the binary doesn't
+// assume. Lane code is written against juce::dsp::SIMDRegister<float>'s interface: expand, fromRawArray,
+// copyToRawArray, the arithmetic operators, & with a comparison mask, and the static min, max, abs, truncate and
+// comparison functions.
+
+// Shared by the scalar oscillators and every lane kernel so all paths run identical maths.
+struct SawCoreConstants final
+{
+    static constexpr float hfCompA0 = 2.5f;
+    static constexpr float hfCompA1 = -1.5f;
+};
+
+// The polynomial sine in lane form; FastSine::polynomial() is its scalar twin and uses the same coefficients.
+struct PolynomialSine final
+{
+    static constexpr float c0 = 6.283185160e+00f;
+    static constexpr float c1 = -4.134165503e+01f;
+    static constexpr float c2 = 8.160100407e+01f;
+    static constexpr float c3 = -7.654978229e+01f;
+    static constexpr float c4 = 3.953670606e+01f;
+
+    template <typename Lanes>
+    static Lanes sinTwoPi (Lanes phase) noexcept
+    {
+        const auto one = Lanes::expand (1.0f);
+        const auto quarter = Lanes::expand (0.25f);
+
+        auto wrapped = phase - Lanes::truncate (phase);
+        const auto above = one & Lanes::greaterThan (wrapped, Lanes::expand (0.5f));
+        const auto below = one & Lanes::lessThan (wrapped, Lanes::expand (-0.5f));
+        wrapped = (wrapped - above) + below;
+
+        const auto magnitude = quarter - Lanes::abs (Lanes::abs (wrapped) - quarter);
+        const auto folded = magnitude - ((magnitude + magnitude) & Lanes::lessThan (wrapped, Lanes::expand (0.0f)));
+        const auto z = folded * folded;
+
+        auto series = (z * Lanes::expand (c4)) + Lanes::expand (c3);
+        series = (z * series) + Lanes::expand (c2);
+        series = (z * series) + Lanes::expand (c1);
+        series = (z * series) + Lanes::expand (c0);
+
+        return folded * series;
+    }
+};
+
+// Coefficients of LowPassSvf, which the voice bank's kernels share between lanes.
+struct SvfCoefficients
+{
+    float a1 = 1.0f, a2 = 0.0f, a3 = 0.0f;
+
+    static SvfCoefficients fromG (float g) noexcept
+    {
+        constexpr auto k = 1.41421356f;
+        const auto a1 = 1.0f / (1.0f + (g * (g + k)));
+        return { a1, g * a1, g * (g * a1) };
+    }
+};
+
+//==============================================================================
+// One AntiAliasedPulseOscillator per SIMD lane: a lane-for-lane transcription of its float kernel. Sine supplies a
+// static sinTwoPi (Lanes). With the polynomial sine kernel and no FMA contraction every lane reproduces the scalar
+// oscillator bit for bit.
+template <typename LaneType, typename Sine>
+struct BasicPulseLanes
+{
+    using Lanes = LaneType;
+    static constexpr int laneCount = static_cast<int> (Lanes::SIMDNumElements);
+
+    // Advances every lane one sample at the given widths, already clamped; returns the clipped pulse.
+    Lanes step (Lanes pulseWidth) noexcept
+    {
+        const auto leadingInput = Sine::sinTwoPi (leadingPhase + (leadingOsc * beta));
+        leadingOsc = (leadingOsc + leadingInput) * half;
+        const auto leadingFiltered = (leadingOsc * hfCompA0) + (leadingPrevious * hfCompA1);
+        leadingPrevious = leadingOsc;
+        const auto leading = (leadingFiltered - dc) * inverseNorm;
+
+        leadingPhase = leadingPhase + w;
+        leadingPhase = leadingPhase - (one & Lanes::greaterThanOrEqual (leadingPhase, one));
+
+        auto shiftedPhase = leadingPhase + pulseWidth;
+        shiftedPhase = shiftedPhase - (one & Lanes::greaterThanOrEqual (shiftedPhase, one));
+
+        const auto trailingInput = Sine::sinTwoPi (shiftedPhase + (trailingOsc * beta));
+        trailingOsc = (trailingOsc + trailingInput) * half;
+        const auto trailingFiltered = (trailingOsc * hfCompA0) + (trailingPrevious * hfCompA1);
+        trailingPrevious = trailingOsc;
+        const auto trailing = (trailingFiltered - dc) * inverseNorm;
+
+        trailingPhase = shiftedPhase + w;
+        trailingPhase = trailingPhase - (one & Lanes::greaterThanOrEqual (trailingPhase, one));
+
+        return Lanes::min (one, Lanes::max (lowerLimit, leading - trailing));
+    }
+
+    Lanes leadingPhase, leadingOsc, leadingPrevious;
+    Lanes trailingPhase, trailingOsc, trailingPrevious;
+    Lanes w, beta, dc, inverseNorm;   // Per-frequency constants; both edges share the leading edge's.
+
+    const Lanes one = Lanes::expand (1.0f);
+    const Lanes half = Lanes::expand (0.5f);
+    const Lanes hfCompA0 = Lanes::expand (SawCoreConstants::hfCompA0);
+    const Lanes hfCompA1 = Lanes::expand (SawCoreConstants::hfCompA1);
+    const Lanes lowerLimit = Lanes::expand (-1.0f);
+};
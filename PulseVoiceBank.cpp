@@ -0,0 +1,266 @@
+#include "PulseVoiceBank.h"
+
+#include "FastSine.h"
+
+#include <atomic>
+
+//==============================================================================
+// The baseline kernels are whatever juce::dsp::SIMDRegister compiles to for the whole binary.
+namespace
+{
+    using BaselineRenderer = PulseBankRenderer<juce::dsp::SIMDRegister<float>, FastSine>;
+
+    constexpr PulseBankKernels baselineKernels { &BaselineRenderer::processBiquad, &BaselineRenderer::processSvf, &BaselineRenderer::processUnison };
+
+    constexpr PulseVoiceBank::InstructionSet instructionSets[] { PulseVoiceBank::InstructionSet::baseline,
+                                                                 PulseVoiceBank::InstructionSet::avx2,
+                                                                 PulseVoiceBank::InstructionSet::avx512 };
+
+    // Each wider table is only asked for once the CPU is known to run it; see PulseBankKernels.h.
+    const PulseBankKernels* findKernels (PulseVoiceBank::InstructionSet set) noexcept
+    {
+        switch (set)
+        {
+            case PulseVoiceBank::InstructionSet::avx2:     return juce::SystemStats::hasAVX2() ? getPulseBankAvx2Kernels() : nullptr;
+            case PulseVoiceBank::InstructionSet::avx512:   return juce::SystemStats::hasAVX512F() ? getPulseBankAvx512Kernels() : nullptr;
+            case PulseVoiceBank::InstructionSet::baseline: break;
+        }
+
+        return &baselineKernels;
+    }
+
+    bool findInstructionSet (const juce::String& name, PulseVoiceBank::InstructionSet& result) noexcept
+    {
+        for (auto set : instructionSets)
+        {
+            if (name.equalsIgnoreCase (PulseVoiceBank::getName (set))
+                 || (set == PulseVoiceBank::InstructionSet::baseline && name.equalsIgnoreCase ("baseline")))
+            {
+                result = set;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    PulseVoiceBank::InstructionSet chooseInstructionSet()
+    {
+        const auto requested = juce::SystemStats::getEnvironmentVariable ("DPLUGIN_ISA", {}).trim();
+        auto set = PulseVoiceBank::InstructionSet::baseline;
+
+        if (requested.isNotEmpty() && findInstructionSet (requested, set) && PulseVoiceBank::isSupported (set))
+            return set;
+
+        // A request this machine can't honour, such as a bug report's ISA on a different CPU, falls back to the widest.
+        if (requested.isNotEmpty())
+            DBG ("DPLUGIN_ISA " << requested << " is not available here");
+
+        for (auto candidate : instructionSets)
+            if (PulseVoiceBank::isSupported (candidate))
+                set = candidate;
+
+        return set;
+    }
+
+    struct ActiveKernels
+    {
+        ActiveKernels()
+        {
+            const auto initial = chooseInstructionSet();
+            set.store (initial);
+            kernels.store (findKernels (initial));
+        }
+
+        std::atomic<PulseVoiceBank::InstructionSet> set;
+        std::atomic<const PulseBankKernels*> kernels;
+    };
+
+    ActiveKernels& getActiveKernels()
+    {
+        static ActiveKernels active;
+        return active;
+    }
+}
+
+const PulseBankKernels& getActivePulseBankKernels() noexcept
+{
+    return *getActiveKernels().kernels.load();
+}
+
+PulseVoiceBank::InstructionSet PulseVoiceBank::getInstructionSet() noexcept
+{
+    return getActiveKernels().set.load();
+}
+
+bool PulseVoiceBank::setInstructionSet (InstructionSet newSet) noexcept
+{
+    const auto* kernels = findKernels (newSet);
+
+    if (newSet != InstructionSet::baseline && kernels == nullptr)
+        return false;
+
+    auto& active = getActiveKernels();
+    active.kernels.store (kernels);
+    active.set.store (newSet);
+    return true;
+}
+
+bool PulseVoiceBank::setInstructionSet (const juce::String& name)
+{
+    auto set = InstructionSet::baseline;
+    return findInstructionSet (name.trim(), set) && setInstructionSet (set);
+}
+
+bool PulseVoiceBank::isSupported (InstructionSet set) noexcept
+{
+    return set == InstructionSet::baseline || findKernels (set) != nullptr;
+}
+
+const char* PulseVoiceBank::getName (InstructionSet set) noexcept
+{
+    switch (set)
+    {
+        case InstructionSet::avx2:     return "avx2";
+        case InstructionSet::avx512:   return "avx512";
+        case InstructionSet::baseline: break;
+    }
+
+   #if JUCE_USE_AVX_INTRINSICS
+    return "avx";
+   #elif JUCE_USE_SSE_INTRINSICS
+    return "sse2";
+   #elif JUCE_USE_ARM_NEON
+    return "neon";
+   #else
+    return "scalar";
+   #endif
+}
+
+//==============================================================================
+void PulseVoiceBank::prepare (int maximumVoices)
+{
+    getActiveKernels();   // Chooses the kernels here, on the message thread, rather than in the first render.
+
+    const auto numGroups = (juce::jmax (1, maximumVoices) + PulseBankGroup::numLanes - 1) / PulseBankGroup::numLanes;
+    groups.assign (static_cast<size_t> (numGroups), PulseBankGroup {});
+    numVoices = 0;
+}
+
+int PulseVoiceBank::add (const AntiAliasedPulseOscillator& oscillator, const LowPassBiquad& filter, float level) noexcept
+{
+    const auto lane = addOscillator (oscillator, level);
+
+    if (lane < 0)
+        return -1;
+
+    auto& group = groups[static_cast<size_t> (lane / PulseBankGroup::numLanes)];
+    const auto i = lane % PulseBankGroup::numLanes;
+
+    group.b0[i] = filter.b0;
+    group.b1[i] = filter.b1;
+    group.b2[i] = filter.b2;
+    group.a1[i] = filter.a1;
+    group.a2[i] = filter.a2;
+    group.z1[i] = static_cast<float> (filter.z1);
+    group.z2[i] = static_cast<float> (filter.z2);
+
+    return lane;
+}
+
+int PulseVoiceBank::add (const AntiAliasedPulseOscillator& oscillator, const LowPassSvf& filter, float level) noexcept
+{
+    const auto lane = addOscillator (oscillator, level);
+
+    if (lane < 0)
+        return -1;
+
+    auto& group = groups[static_cast<size_t> (lane / PulseBankGroup::numLanes)];
+    const auto i = lane % PulseBankGroup::numLanes;
+
+    group.z1[i] = static_cast<float> (filter.ic1eq);
+    group.z2[i] = static_cast<float> (filter.ic2eq);
+
+    return lane;
+}
+
+int PulseVoiceBank::addOscillator (const AntiAliasedPulseOscillator& oscillator, float level) noexcept
+{
+    if (numVoices >= getCapacity())
+        return -1;
+
+    const auto lane = numVoices++;
+    auto& group = groups[static_cast<size_t> (lane / PulseBankGroup::numLanes)];
+    const auto i = lane % PulseBankGroup::numLanes;
+
+    const auto& leading = oscillator.leadingEdge;
+    const auto& trailing = oscillator.trailingEdge;
+
+    group.leadingPhase[i] = static_cast<float> (leading.phase);
+    group.leadingOsc[i] = static_cast<float> (leading.osc);
+    group.leadingPrevious[i] = static_cast<float> (leading.previousInput);
+    group.trailingPhase[i] = static_cast<float> (trailing.phase);
+    group.trailingOsc[i] = static_cast<float> (trailing.osc);
+    group.trailingPrevious[i] = static_cast<float> (trailing.previousInput);
+
+    // Both edges are always tuned together, so the leading edge's per-frequency constants serve the pair.
+    group.w[i] = leading.w;
+    group.beta[i] = leading.beta;
+    group.dc[i] = leading.dc;
+    group.inverseNorm[i] = leading.inverseNorm;
+    group.pulseWidth[i] = oscillator.pulseWidth;
+
+    group.level[i] = level;
+
+    return lane;
+}
+
+void PulseVoiceBank::store (int lane, AntiAliasedPulseOscillator& oscillator, LowPassBiquad& filter) const noexcept
+{
+    storeOscillator (lane, oscillator);
+
+    const auto& group = groups[static_cast<size_t> (lane / PulseBankGroup::numLanes)];
+    const auto i = lane % PulseBankGroup::numLanes;
+
+    filter.z1 = group.z1[i];
+    filter.z2 = group.z2[i];
+}
+
+void PulseVoiceBank::store (int lane, AntiAliasedPulseOscillator& oscillator, LowPassSvf& filter) const noexcept
+{
+    storeOscillator (lane, oscillator);
+
+    const auto& group = groups[static_cast<size_t> (lane / PulseBankGroup::numLanes)];
+    const auto i = lane % PulseBankGroup::numLanes;
+
+    filter.ic1eq = group.z1[i];
+    filter.ic2eq = group.z2[i];
+}
+
+void PulseVoiceBank::storeOscillator (int lane, AntiAliasedPulseOscillator& oscillator) const noexcept
+{
+    jassert (juce::isPositiveAndBelow (lane, numVoices));
+
+    const auto& group = groups[static_cast<size_t> (lane / PulseBankGroup::numLanes)];
+    const auto i = lane % PulseBankGroup::numLanes;
+
+    oscillator.leadingEdge.phase = group.leadingPhase[i];
+    oscillator.leadingEdge.osc = group.leadingOsc[i];
+    oscillator.leadingEdge.previousInput = group.leadingPrevious[i];
+    oscillator.trailingEdge.phase = group.trailingPhase[i];
+    oscillator.trailingEdge.osc = group.trailingOsc[i];
+    oscillator.trailingEdge.previousInput = group.trailingPrevious[i];
+}
+
+//==============================================================================
+void PulseVoiceBank::process (float* mix, const float* pulseWidths, int numSamples) noexcept
+{
+    getActiveKernels().kernels.load()->biquad (groups.data(), numVoices, mix, pulseWidths, numSamples);
+}
+
+void PulseVoiceBank::process (float* mix, const float* pulseWidths, const LowPassSvf::Coefficients& coefficients,
+                              const LowPassSvf::Coefficients* coefficientRamp, int numSamples) noexcept
+{
+    getActiveKernels().kernels.load()->svf (groups.data(), numVoices, mix, pulseWidths, coefficients, coefficientRamp,
+                                            numSamples);
+}
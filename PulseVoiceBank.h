@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Oscillators.h"
+#include "PulseBankKernels.h"
+
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+//==============================================================================
+// Structure-of-arrays workspace that steps the pulse oscillators and low-pass filters of several voices at once,
+// one voice per SIMD lane, in groups of 16 that the kernels step 4 (SSE/NEON), 8 (AVX2) or 16 (AVX-512) at a time.
+// Voices stay the owners of their state: a render call gathers the active voices in, runs every lane group across
+// the whole block and scatters the state back. With the polynomial sine kernel and no FMA contraction the lanes
+// reproduce AntiAliasedPulseOscillator + LowPassBiquad bit for bit at every width, so the paths can be compared
+// directly; VoiceBankTest.cpp does, at every instruction set and through the whole processor.
+class PulseVoiceBank final
+{
+public:
+    // The kernels' instruction sets, for the bank and for UnisonOscillator's stacks. Baseline is what the whole binary
+    // targets (SSE2 on x86-64, NEON on ARM64); the wider sets are built into translation units of their own (see
+    // PulseBankKernels.h).
+    enum class InstructionSet
+    {
+        baseline,
+        avx2,
+        avx512
+    };
+
+    // Process-wide, chosen before the first bank is prepared: the widest set this build and CPU support, unless the
+    // DPLUGIN_ISA environment variable names another. setInstructionSet() forces one for benchmarks and bug
+    // reports; it changes nothing and returns false for a set, or a name, this build or CPU can't run.
+    static InstructionSet getInstructionSet() noexcept;
+    static bool setInstructionSet (InstructionSet newSet) noexcept;
+    static bool setInstructionSet (const juce::String& name);
+    static bool isSupported (InstructionSet set) noexcept;
+    static const char* getName (InstructionSet set) noexcept;   // "avx2", or the baseline's own, such as "sse2".
+
+    void prepare (int maximumVoices);
+    void clear() noexcept { numVoices = 0; }
+
+    // Copies a voice into the next free lane and returns that lane, or -1 when the bank is full.
+    // All voices of one block must use the same filter type, and process() must be the matching overload.
+    int add (const AntiAliasedPulseOscillator& oscillator, const LowPassBiquad& filter, float level) noexcept;
+    int add (const AntiAliasedPulseOscillator& oscillator, const LowPassSvf& filter, float level) noexcept;
+    void store (int lane, AntiAliasedPulseOscillator& oscillator, LowPassBiquad& filter) const noexcept;
+    void store (int lane, AntiAliasedPulseOscillator& oscillator, LowPassSvf& filter) const noexcept;
+
+    // Adds the filtered output of every occupied lane to mix, summing lanes in the order the voices were added.
+    // A non-null pulseWidths overrides every lane's width sample by sample, as the oscillator's overload does.
+    void process (float* mix, const float* pulseWidths, int numSamples) noexcept;
+
+    // SVF version: the coefficients are shared by all lanes, either constant or one set per sample.
+    void process (float* mix, const float* pulseWidths, const LowPassSvf::Coefficients& coefficients,
+                  const LowPassSvf::Coefficients* coefficientRamp, int numSamples) noexcept;
+
+    int getNumVoices() const noexcept { return numVoices; }
+    int getCapacity() const noexcept  { return static_cast<int> (groups.size()) * PulseBankGroup::numLanes; }
+
+private:
+    int addOscillator (const AntiAliasedPulseOscillator& oscillator, float level) noexcept;
+    void storeOscillator (int lane, AntiAliasedPulseOscillator& oscillator) const noexcept;
+
+    std::vector<PulseBankGroup> groups;
+    int numVoices = 0;
+};
@@ -0,0 +1,83 @@
+#include "PluginProcessor.h"
+#include "ParameterIDs.h"
+
+#include <cstdio>
+
+// Checks that AntiAliasedSynthesiser's event scheduling holds the minimum sub-block size under dense MIDI: a
+// controller every few samples (pan, slide, mod wheel, pitch wheel) with notes starting and stopping between them.
+// Every run a controller split cuts must be at least the minimum long; only a block's end may cut one shorter.
+// Registered with CTest (see CMakeLists.txt); nothing here runs in the plugin.
+//
+// Exit codes: 0 = every case held the minimum, 1 = a run was shorter.
+
+namespace
+{
+constexpr double sampleRate = 48000.0;
+constexpr int numBlocks = 40;
+
+bool checkMinimum (int minimumSubBlockSize, int blockSize, int controllerSpacing)
+{
+    AudioPluginAudioProcessor processor;
+    processor.setMinimumSubBlockSize (minimumSubBlockSize);
+    processor.setPlayConfigDetails (0, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+    auto sample = 0;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        midi.clear();
+
+        for (int i = 0; i < blockSize; ++i, ++sample)
+        {
+            if (sample % controllerSpacing == 0)
+            {
+                const auto value = (sample / controllerSpacing) % 128;
+
+                midi.addEvent (juce::MidiMessage::controllerEvent (1, 10, value), i);
+                midi.addEvent (juce::MidiMessage::controllerEvent (1, 74, 127 - value), i);
+                midi.addEvent (juce::MidiMessage::controllerEvent (1, 1, value), i);
+                midi.addEvent (juce::MidiMessage::pitchWheel (1, 8192 + 32 * (value - 64)), i);
+            }
+
+            // Notes land between the controllers, so each one follows a controller that was delayed past it.
+            if (sample % 53 == 7)
+                midi.addEvent (juce::MidiMessage::noteOn (1, 36 + (sample / 53) % 48, 0.8f), i);
+            else if (sample % 53 == 41)
+                midi.addEvent (juce::MidiMessage::noteOff (1, 36 + (sample / 53) % 48), i);
+        }
+
+        processor.processBlock (buffer, midi);
+    }
+
+    const auto minimum = processor.getRenderMinimumSubBlockSize();
+    const auto shortest = processor.getShortestControllerRun();
+    processor.releaseResources();
+
+    // With the minimum below the block size some controller must have split a block.
+    const auto passed = shortest > 0 ? shortest >= minimum : minimumSubBlockSize >= blockSize;
+
+    std::printf ("  minimum %4d, block %4d, controllers every %2d samples: shortest run %4d of %4d at the render rate  %s\n",
+                 minimumSubBlockSize, blockSize, controllerSpacing, shortest, minimum, passed ? "ok" : "FAILED");
+    return passed;
+}
+}
+
+//==============================================================================
+int main()
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;   // The processor's parameter state needs a message manager.
+    auto passed = true;
+
+    std::printf ("Controller runs against the minimum sub-block size\n");
+
+    for (const auto minimum : { 1, 8, 32, 100 })
+        for (const auto blockSize : { 64, 256, 512 })
+            for (const auto spacing : { 1, 4, 13 })
+                passed = checkMinimum (minimum, blockSize, spacing) && passed;
+
+    std::printf ("\n%s\n", passed ? "All cases passed" : "Some cases FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#include "SharedTables.h"
+
+//==============================================================================
+class SharedTables::Builder final : public juce::Thread
+{
+public:
+    explicit Builder (SharedTables& ownerTables)
+        : juce::Thread ("DPlugin table builder"), owner (ownerTables)
+    {
+    }
+
+    void run() override
+    {
+        owner.sawStorage = std::make_unique<SawWavetables>();
+        owner.sawWavetables.store (owner.sawStorage.get(), std::memory_order_release);
+        owner.built.signal();
+    }
+
+private:
+    SharedTables& owner;
+};
+
+//==============================================================================
+SharedTables::SharedTables()
+    : builder (std::make_unique<Builder> (*this))
+{
+    // Without a thread to spare the first instance builds in place, a few milliseconds rather than never.
+    if (! builder->startThread())
+        builder->run();
+}
+
+SharedTables::~SharedTables()
+{
+    builder->waitForThreadToExit (-1);
+}
+
+const SawWavetables& SharedTables::waitForSawWavetables() const noexcept
+{
+    built.wait (-1.0);
+    return *getSawWavetables();
+}
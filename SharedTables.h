@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Wavetables.h"
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+// Immutable tables shared by every plugin instance in the process, held through
+// juce::SharedResourcePointer<SharedTables>: the first instance creates them and starts the build on a
+// background thread, later instances only take a reference, and the last one to go frees them. FastSine's
+// lookup table needs no entry here; it is computed at compile time.
+class SharedTables final
+{
+public:
+    SharedTables();
+    ~SharedTables();   // Waits for a build still in progress.
+
+    // Null until the background build has finished; callers fall back to table-free code until then.
+    const SawWavetables* getSawWavetables() const noexcept   { return sawWavetables.load (std::memory_order_acquire); }
+
+    // Blocks until the tables exist, for callers that cannot fall back, such as an offline render.
+    const SawWavetables& waitForSawWavetables() const noexcept;
+
+private:
+    class Builder;
+
+    std::unique_ptr<SawWavetables> sawStorage;   // Written once, by the builder.
+    std::atomic<const SawWavetables*> sawWavetables { nullptr };
+    juce::WaitableEvent built { true };
+    std::unique_ptr<Builder> builder;
+
+    JUCE_DECLARE_NON_COPYABLE (SharedTables)
+};
@@ -0,0 +1,262 @@
+#include "SmoothedParameters.h"
+#include "ParameterIDs.h"
+
+#include <type_traits>
+
+SmoothedParameters::SmoothedParameters (juce::AudioProcessorValueTreeState& vts)
+    : SmoothedParameters ([&vts] (const char* parameterID) { return vts.getRawParameterValue (parameterID); })
+{
+}
+
+SmoothedParameters::SmoothedParameters (const RawValueLookup& lookup)
+{
+    gainParam = lookup (gainParamID);
+    pulseWidthParam = lookup (pulseWidthParamID);
+    filterCutoffParam = lookup (filterCutoffParamID);
+    filterTypeParam = lookup (filterTypeParamID);
+    oscillatorEngineParam = lookup (oscillatorEngineParamID);
+    attackParam = lookup (attackParamID);
+    decayParam = lookup (decayParamID);
+    sustainParam = lookup (sustainParamID);
+    releaseParam = lookup (releaseParamID);
+    unisonVoicesParam = lookup (unisonVoicesParamID);
+    unisonDetuneParam = lookup (unisonDetuneParamID);
+    unisonSpreadParam = lookup (unisonSpreadParamID);
+    mpeBendRangeParam = lookup (mpeBendRangeParamID);
+
+    jassert (gainParam != nullptr);
+    jassert (pulseWidthParam != nullptr);
+    jassert (filterCutoffParam != nullptr);
+    jassert (filterTypeParam != nullptr);
+    jassert (oscillatorEngineParam != nullptr);
+    jassert (attackParam != nullptr && decayParam != nullptr && sustainParam != nullptr && releaseParam != nullptr);
+    jassert (unisonVoicesParam != nullptr && unisonDetuneParam != nullptr && unisonSpreadParam != nullptr);
+    jassert (mpeBendRangeParam != nullptr);
+}
+
+void SmoothedParameters::prepare (double sampleRate, int maximumBlockSize, int oversamplingFactor)
+{
+    outputSampleRate = sampleRate;
+    ramps.setSize (3, juce::jmax (1, maximumBlockSize));
+    svfRamp.resize (static_cast<size_t> (juce::jmax (1, maximumBlockSize)));
+
+    gain.setCurrentAndTargetValue (gainFromDecibels (gainParam->load()));
+    pulseWidth.setCurrentAndTargetValue (pulseWidthParam->load());
+    filterCutoff.setCurrentAndTargetValue (filterCutoffParam->load());
+
+    setOversamplingFactor (oversamplingFactor);
+}
+
+void SmoothedParameters::snapToParameters() noexcept
+{
+    gain.setCurrentAndTargetValue (gainFromDecibels (gainParam->load()));
+    pulseWidth.setCurrentAndTargetValue (pulseWidthParam->load());
+    filterCutoff.setCurrentAndTargetValue (filterCutoffParam->load());
+    updateSteadyValues();
+}
+
+// Everything the voices read outside the ramps, from the smoothers' current values and the unsmoothed parameters.
+void SmoothedParameters::updateSteadyValues() noexcept
+{
+    gainIsRamping = false;
+    pulseWidthIsRamping = false;
+    svfIsRamping = false;
+    filterType = filterTypeParam->load() >= 0.5f ? VoiceFilterType::svf : VoiceFilterType::biquad;
+    oscillatorEngine = oscillatorEngineParam->load() >= 0.5f ? OscillatorEngine::wavetable : OscillatorEngine::feedbackFm;
+    updateFilterCoefficients();
+    svfCoefficients = LowPassSvf::Coefficients::fromG (gFromCutoffAmount (filterCutoff.getCurrentValue()));
+    updateEnvelopeShape();
+    updateUnison();
+    mpeBendRange = mpeBendRangeParam->load();
+}
+
+// The smoothers keep their values and targets across the new rate, so a quality or engine switch mid-ramp carries
+// on from where it was; a ramp in progress restarts over the full ramp length at the new rate.
+void SmoothedParameters::setOversamplingFactor (int newFactor) noexcept
+{
+    currentSampleRate = outputSampleRate * juce::jmax (1, newFactor);
+
+    for (size_t i = 0; i < gTable.size(); ++i)
+    {
+        const auto cutoff = cutoffInHz (static_cast<float> (i) / static_cast<float> (gTableSize));
+        gTable[i] = static_cast<float> (std::tan (juce::MathConstants<double>::pi * cutoff / currentSampleRate));
+    }
+
+    for (auto* value : { &gain, &pulseWidth, &filterCutoff })
+    {
+        const auto current = value->getCurrentValue();
+        const auto target = value->getTargetValue();
+
+        value->reset (currentSampleRate, rampLengthSeconds);
+        value->setCurrentAndTargetValue (current);
+        value->setTargetValue (target);
+    }
+
+    updateSteadyValues();
+}
+
+void SmoothedParameters::saveState() noexcept
+{
+    savedState = { gain, pulseWidth, filterCutoff, filterCoefficients, filterCoefficientsCutoff, svfCoefficients };
+}
+
+void SmoothedParameters::restoreState() noexcept
+{
+    gain = savedState.gain;
+    pulseWidth = savedState.pulseWidth;
+    filterCutoff = savedState.filterCutoff;
+    filterCoefficients = savedState.filterCoefficients;
+    filterCoefficientsCutoff = savedState.filterCoefficientsCutoff;
+    svfCoefficients = savedState.svfCoefficients;
+}
+
+void SmoothedParameters::process (int numSamples) noexcept
+{
+    gain.setTargetValue (gainFromDecibels (gainParam->load()));
+    gainIsRamping = fillRamp (gain, gainRampChannel, numSamples);
+
+    pulseWidth.setTargetValue (pulseWidthParam->load());
+    pulseWidthIsRamping = fillRamp (pulseWidth, pulseWidthRampChannel, numSamples);
+
+    filterCutoff.setTargetValue (filterCutoffParam->load());
+    filterType = filterTypeParam->load() >= 0.5f ? VoiceFilterType::svf : VoiceFilterType::biquad;
+    oscillatorEngine = oscillatorEngineParam->load() >= 0.5f ? OscillatorEngine::wavetable : OscillatorEngine::feedbackFm;
+    updateEnvelopeShape();
+    updateUnison();
+    mpeBendRange = mpeBendRangeParam->load();
+
+    if (filterType == VoiceFilterType::svf)
+    {
+        updateSvfCoefficients (numSamples);
+    }
+    else
+    {
+        svfIsRamping = false;
+
+        if (filterCutoff.isSmoothing())
+            filterCutoff.skip (numSamples);
+
+        // Also after the SVF moved the cutoff, so switching back to the biquad never plays its old coefficients.
+        if (filterCutoff.getCurrentValue() != filterCoefficientsCutoff)
+            updateFilterCoefficients();
+    }
+}
+
+void SmoothedParameters::applyGain (juce::AudioBuffer<float>& buffer, int numSamples) const noexcept
+{
+    applyGainTo (buffer, numSamples);
+}
+
+void SmoothedParameters::applyGain (juce::AudioBuffer<double>& buffer, int numSamples) const noexcept
+{
+    applyGainTo (buffer, numSamples);
+}
+
+// The gain ramp is float either way; a double buffer widens it sample by sample.
+template <typename SampleType>
+void SmoothedParameters::applyGainTo (juce::AudioBuffer<SampleType>& buffer, int numSamples) const noexcept
+{
+    if (! gainIsRamping)
+    {
+        buffer.applyGain (0, numSamples, static_cast<SampleType> (gain.getCurrentValue()));
+        return;
+    }
+
+    const auto* gains = ramps.getReadPointer (gainRampChannel);
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* samples = buffer.getWritePointer (channel);
+
+        if constexpr (std::is_same_v<SampleType, float>)
+            juce::FloatVectorOperations::multiply (samples, gains, numSamples);
+        else
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] *= static_cast<SampleType> (gains[i]);
+    }
+}
+
+// Envelope times are not smoothed: voices pick up a change at the next block and bend their running segment.
+void SmoothedParameters::updateEnvelopeShape() noexcept
+{
+    envelopeShape = SegmentEnvelope::Shape::fromTimes (currentSampleRate, attackParam->load(), decayParam->load(),
+                                                       sustainParam->load(), releaseParam->load());
+}
+
+// Detune retunes the layers at the next block, which sounds like a glide at these rates; no smoothing needed.
+void SmoothedParameters::updateUnison() noexcept
+{
+    unisonVoices = juce::roundToInt (unisonVoicesParam->load());
+    unisonDetune = unisonDetuneParam->load();
+    unisonSpread = unisonSpreadParam->load();
+}
+
+// Returns false, without touching the buffer, when the value is already at its target.
+bool SmoothedParameters::fillRamp (juce::SmoothedValue<float>& value, int channel, int numSamples) noexcept
+{
+    if (! value.isSmoothing())
+        return false;
+
+    if (numSamples > ramps.getNumSamples())
+    {
+        jassertfalse;   // The host sent a bigger block than prepareToPlay() announced; step instead of ramping.
+        value.skip (numSamples);
+        return false;
+    }
+
+    auto* samples = ramps.getWritePointer (channel);
+
+    for (int i = 0; i < numSamples; ++i)
+        samples[i] = value.getNextValue();
+
+    return true;
+}
+
+void SmoothedParameters::updateFilterCoefficients() noexcept
+{
+    if (currentSampleRate <= 0.0)
+        return;
+
+    filterCoefficientsCutoff = filterCutoff.getCurrentValue();
+    filterCoefficients = juce::IIRCoefficients::makeLowPass (currentSampleRate, cutoffInHz (filterCoefficientsCutoff));
+}
+
+// One table lookup and one division per sample for the whole synth, instead of tan() per voice.
+void SmoothedParameters::updateSvfCoefficients (int numSamples) noexcept
+{
+    // The biquad path may have left the cutoff mid-ramp; the SVF picks it up from wherever it is.
+    svfIsRamping = fillRamp (filterCutoff, cutoffRampChannel, numSamples);
+
+    if (svfIsRamping)
+    {
+        const auto* cutoffs = ramps.getReadPointer (cutoffRampChannel);
+
+        for (int i = 0; i < numSamples; ++i)
+            svfRamp[static_cast<size_t> (i)] = LowPassSvf::Coefficients::fromG (gFromCutoffAmount (cutoffs[i]));
+    }
+
+    svfCoefficients = LowPassSvf::Coefficients::fromG (gFromCutoffAmount (filterCutoff.getCurrentValue()));
+}
+
+juce::IIRCoefficients SmoothedParameters::getFilterCoefficientsFor (float cutoffAmount) const noexcept
+{
+    return juce::IIRCoefficients::makeLowPass (currentSampleRate, cutoffInHz (juce::jlimit (0.0f, 1.0f, cutoffAmount)));
+}
+
+// Same mapping the voices used to compute individually: 0 = open (0.45 * output rate), 1 = 200 Hz.
+float SmoothedParameters::cutoffInHz (float cutoffAmount) const noexcept
+{
+    const auto maxCutoff = static_cast<float> (outputSampleRate * 0.45);
+    const auto minCutoff = 200.0f;
+    return juce::jmap (cutoffAmount, 0.0f, 1.0f, maxCutoff, minCutoff);
+}
+
+// Linear interpolation in the table; worst case about 0.03 % off tan(), right at the open end of the range.
+float SmoothedParameters::gFromCutoffAmount (float cutoffAmount) const noexcept
+{
+    const auto position = juce::jlimit (0.0f, 1.0f, cutoffAmount) * static_cast<float> (gTableSize);
+    const auto index = juce::jmin (gTableSize - 1, static_cast<int> (position));
+    const auto fraction = position - static_cast<float> (index);
+    const auto lower = gTable[static_cast<size_t> (index)];
+    return lower + (fraction * (gTable[static_cast<size_t> (index) + 1] - lower));
+}
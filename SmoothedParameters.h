@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Envelope.h"
+#include "Oscillators.h"
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+//==============================================================================
+// Reads the APVTS parameters once per processBlock(), smooths them, and publishes the results for every voice.
+// If a parameter is steady over a block, its ramp pointer is null and the voices use a single constant.
+// Filter coefficients are worked out here once for all voices: the biquad's at block rate (makeLowPass needs
+// trig), the SVF's per sample from a cutoff -> g table. Output gain is applied after the voices are summed.
+// Everything runs at the render rate, i.e. the output rate times the oversampling factor; the cutoff control
+// stays mapped against the output rate so every factor sounds the same apart from aliasing.
+class SmoothedParameters final
+{
+public:
+    explicit SmoothedParameters (juce::AudioProcessorValueTreeState& vts);
+
+    // Reads the raw values lookup returns for each parameter ID instead, e.g. a multi-timbral part's own set.
+    using RawValueLookup = std::function<std::atomic<float>* (const char* parameterID)>;
+    explicit SmoothedParameters (const RawValueLookup& lookup);
+
+    // Sizes the ramp buffers for maximumBlockSize render-rate samples and jumps every value to its parameter's current setting.
+    void prepare (double sampleRate, int maximumBlockSize, int oversamplingFactor = 1);
+
+    // Moves to another render rate without reallocating, keeping values and ramps; prepare()'s block size must
+    // cover the new factor.
+    void setOversamplingFactor (int newFactor) noexcept;
+
+    // Jumps every value to its parameter's current setting, without the ramps; for a parameter set taking over.
+    void snapToParameters() noexcept;
+
+    // Advances every ramp by numSamples render-rate samples; call once per rendered block.
+    void process (int numSamples) noexcept;
+
+    // Snapshot and restore of the smoothers, so a block can be rendered twice from the same ramps, as the
+    // processor's engine crossfade does. One snapshot is kept; neither call allocates.
+    void saveState() noexcept;
+    void restoreState() noexcept;
+
+    // Multiplies the rendered block by the output gain, sample by sample only while the gain is moving.
+    void applyGain (juce::AudioBuffer<float>& buffer, int numSamples) const noexcept;
+    void applyGain (juce::AudioBuffer<double>& buffer, int numSamples) const noexcept;
+
+    float getGain() const noexcept              { return gain.getCurrentValue(); }         // Linear, at the end of the block.
+    float getPulseWidth() const noexcept        { return pulseWidth.getCurrentValue(); }   // Value at the end of the block.
+    const float* getPulseWidthRamp() const noexcept { return pulseWidthIsRamping ? ramps.getReadPointer (pulseWidthRampChannel) : nullptr; }
+    VoiceFilterType getFilterType() const noexcept { return filterType; }
+    OscillatorEngine getOscillatorEngine() const noexcept { return oscillatorEngine; }   // Read once per block.
+    const juce::IIRCoefficients& getFilterCoefficients() const noexcept { return filterCoefficients; }
+    const LowPassSvf::Coefficients& getSvfCoefficients() const noexcept { return svfCoefficients; }       // End of block.
+    const LowPassSvf::Coefficients* getSvfCoefficientRamp() const noexcept { return svfIsRamping ? svfRamp.data() : nullptr; }
+
+    // The cutoff control itself, for voices that move their own cutoff around it. The ramp only exists while the SVF
+    // is ramping, i.e. whenever getSvfCoefficientRamp() does.
+    float getFilterCutoff() const noexcept      { return filterCutoff.getCurrentValue(); }
+    const float* getFilterCutoffRamp() const noexcept { return svfIsRamping ? ramps.getReadPointer (cutoffRampChannel) : nullptr; }
+    LowPassSvf::Coefficients getSvfCoefficientsFor (float cutoffAmount) const noexcept { return LowPassSvf::Coefficients::fromG (gFromCutoffAmount (cutoffAmount)); }
+    juce::IIRCoefficients getFilterCoefficientsFor (float cutoffAmount) const noexcept;   // A tan() and several divisions.
+    const SegmentEnvelope::Shape& getEnvelopeShape() const noexcept { return envelopeShape; }                // Per block, at the render rate.
+    int getUnisonVoices() const noexcept        { return unisonVoices; }    // Unison settings are read once per block, unsmoothed.
+    float getUnisonDetune() const noexcept      { return unisonDetune; }    // Cents either side of the note.
+    float getUnisonSpread() const noexcept      { return unisonSpread; }    // 0 = mono, 1 = outer layers hard left/right.
+    float getMpeBendRange() const noexcept      { return mpeBendRange; }    // Semitones at full bend on an MPE member channel.
+
+private:
+    static constexpr double rampLengthSeconds = 0.02;
+    static constexpr int gainRampChannel = 0;
+    static constexpr int pulseWidthRampChannel = 1;
+    static constexpr int cutoffRampChannel = 2;
+    static constexpr int gTableSize = 256;
+
+    static float gainFromDecibels (float decibels) noexcept { return juce::Decibels::decibelsToGain (decibels); }
+    bool fillRamp (juce::SmoothedValue<float>& value, int channel, int numSamples) noexcept;
+    void updateSteadyValues() noexcept;
+    template <typename SampleType>
+    void applyGainTo (juce::AudioBuffer<SampleType>& buffer, int numSamples) const noexcept;
+    void updateFilterCoefficients() noexcept;
+    void updateSvfCoefficients (int numSamples) noexcept;
+    void updateEnvelopeShape() noexcept;
+    void updateUnison() noexcept;
+    float cutoffInHz (float cutoffAmount) const noexcept;
+    float gFromCutoffAmount (float cutoffAmount) const noexcept;
+
+    std::atomic<float>* gainParam = nullptr;
+    std::atomic<float>* pulseWidthParam = nullptr;
+    std::atomic<float>* filterCutoffParam = nullptr;
+    std::atomic<float>* filterTypeParam = nullptr;
+    std::atomic<float>* oscillatorEngineParam = nullptr;
+    std::atomic<float>* attackParam = nullptr;
+    std::atomic<float>* decayParam = nullptr;
+    std::atomic<float>* sustainParam = nullptr;
+    std::atomic<float>* releaseParam = nullptr;
+    std::atomic<float>* unisonVoicesParam = nullptr;
+    std::atomic<float>* unisonDetuneParam = nullptr;
+    std::atomic<float>* unisonSpreadParam = nullptr;
+    std::atomic<float>* mpeBendRangeParam = nullptr;
+
+    juce::SmoothedValue<float> gain, pulseWidth, filterCutoff;
+    juce::AudioBuffer<float> ramps;   // One channel per ramped parameter, allocated in prepare().
+    bool gainIsRamping = false;
+    bool pulseWidthIsRamping = false;
+    bool svfIsRamping = false;
+    VoiceFilterType filterType = VoiceFilterType::svf;
+    OscillatorEngine oscillatorEngine = OscillatorEngine::feedbackFm;
+
+    double outputSampleRate = 44100.0;
+    double currentSampleRate = 44100.0;   // Render rate.
+    juce::IIRCoefficients filterCoefficients { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };   // Pass-through until prepare().
+    float filterCoefficientsCutoff = -1.0f;   // The cutoff control filterCoefficients were built for.
+    LowPassSvf::Coefficients svfCoefficients;
+    std::vector<LowPassSvf::Coefficients> svfRamp;
+    SegmentEnvelope::Shape envelopeShape;
+    int unisonVoices = 1;
+    float unisonDetune = 0.0f;
+    float unisonSpread = 0.0f;
+    float mpeBendRange = 48.0f;
+    std::array<float, gTableSize + 1> gTable {};   // tan (pi * fc / fs) over the cutoff control, rebuilt when the render rate changes.
+
+    // What process() advances and the voices can't rebuild from the parameters, as of the last saveState().
+    struct SavedState
+    {
+        juce::SmoothedValue<float> gain, pulseWidth, filterCutoff;
+        juce::IIRCoefficients filterCoefficients;
+        float filterCoefficientsCutoff;
+        LowPassSvf::Coefficients svfCoefficients;
+    };
+
+    SavedState savedState;
+
+    JUCE_DECLARE_NON_COPYABLE (SmoothedParameters)
+};
@@ -0,0 +1,1242 @@
+#include "SynthVoice.h"
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+// Adds source * gain into destination, widening or rounding when the two sample types differ.
+template <typename DestinationType, typename SourceType>
+void addScaled (DestinationType* destination, const SourceType* source, float gain, int numSamples) noexcept
+{
+    if constexpr (std::is_same_v<DestinationType, SourceType>)
+    {
+        if (gain == 1.0f)
+            juce::FloatVectorOperations::add (destination, source, numSamples);
+        else
+            juce::FloatVectorOperations::addWithMultiply (destination, source, static_cast<DestinationType> (gain), numSamples);
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] += static_cast<DestinationType> (source[i]) * static_cast<DestinationType> (gain);
+    }
+}
+
+// The cheapest kernel for what a chunk modulates; with pitch ratios there are always pulse widths too.
+template <typename Oscillator>
+void renderOscillator (Oscillator& oscillator, float* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept
+{
+    if (pitchRatios != nullptr)
+        oscillator.processBlock (output, pulseWidths, pitchRatios, numSamples);
+    else if (pulseWidths != nullptr)
+        oscillator.processBlock (output, pulseWidths, numSamples);
+    else
+        oscillator.processBlock (output, numSamples);
+}
+
+template <typename Oscillator>
+void renderOscillator (Oscillator& oscillator, double* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept
+{
+    if (pitchRatios != nullptr)
+        oscillator.processBlockPrecise (output, pulseWidths, pitchRatios, numSamples);
+    else
+        oscillator.processBlockPrecise (output, pulseWidths, numSamples);
+}
+}
+
+// The processor smooths the parameters once per block; voices only read the shared results.
+AntiAliasedVoice::AntiAliasedVoice (const SmoothedParameters& sharedParameters, const SharedTables& sharedTables)
+    : parameters (&sharedParameters), tables (sharedTables)
+{
+}
+
+bool AntiAliasedVoice::canPlaySound (juce::SynthesiserSound* sound)
+{
+    return dynamic_cast<AntiAliasedSound*> (sound) != nullptr;
+}
+
+// Handle per-note initialisation so every voice restarts with the latest GUI parameters.
+void AntiAliasedVoice::startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound*, int)
+{
+    const auto handover = std::exchange (carryOverState, false);
+    const auto sampleRate = getSampleRate();
+    if (sampleRate <= 0.0)
+    {
+        clearCurrentNote();
+        return;
+    }
+
+    currentLevel = velocity;
+    currentFrequency = static_cast<float> (juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber));
+    pulseOsc.setPulseWidth (parameters->getPulseWidth());
+    pulseOsc.setFrequency (currentFrequency, sampleRate);
+    tableOsc.setPulseWidth (parameters->getPulseWidth());
+    tableOsc.setFrequency (currentFrequency, sampleRate);
+    unison.setLayout (parameters->getUnisonVoices(), parameters->getUnisonDetune(), parameters->getUnisonSpread());
+    unison.setPulseWidth (parameters->getPulseWidth());
+    unison.setFrequency (currentFrequency, sampleRate);
+    lowPassFilter.setCoefficients (parameters->getFilterCoefficients());
+    svfFilter.setCoefficients (parameters->getSvfCoefficients());
+
+    // A handed-over voice keeps running and prepareToRender() picks up any filter type change.
+    if (! handover)
+    {
+        pulseOsc.reset();
+        tableOsc.reset();
+        unison.reset();
+        filterType = parameters->getFilterType();
+        lowPassFilter.reset();
+        svfFilter.reset();
+        renderingStereo = false;
+    }
+
+    expression.reset (0.0f, 0.0f, NoteExpression::neutralSlide);   // The synth follows up with startExpression().
+    envelope.noteOn (parameters->getEnvelopeShape());
+    isActive = true;
+}
+
+// With a tail the envelope releases and prepareToRender() retires the voice once it is silent; without one
+// (all-sound-off, a disabled slot) the voice stops on the spot. A stolen or retriggered voice is stopped the same
+// way just before its next start, so it keeps its state for the handover.
+void AntiAliasedVoice::stopNote (float, bool allowTailOff)
+{
+    if (allowTailOff && isActive)
+    {
+        envelope.noteOff (parameters->getEnvelopeShape());
+        return;
+    }
+
+    clearCurrentNote();
+    isActive = false;
+
+    if (carryOverState)
+        return;
+
+    pulseOsc.reset();
+    tableOsc.reset();
+    envelope.reset();
+    currentLevel = 0.0f;
+}
+
+bool AntiAliasedVoice::prepareToRender() noexcept
+{
+    if (! isVoiceActive() || ! isActive)
+        return false;
+
+    const auto sampleRate = getSampleRate();
+    if (sampleRate <= 0.0)
+        return false;
+
+    envelope.setShape (parameters->getEnvelopeShape());
+
+    if (envelope.isIdle())
+    {
+        stopNote (0.0f, false);
+        return false;
+    }
+
+    if (envelope.isSilent())
+        return false;   // Held at a zero sustain level: nothing to hear until the next note-on.
+
+    // An engine switch mid-note carries on from the other oscillator's own phase, much as a filter switch does.
+    const auto* sawWavetables = tables.getSawWavetables();
+    oscillatorEngine = sawWavetables != nullptr ? parameters->getOscillatorEngine() : OscillatorEngine::feedbackFm;
+    unison.setEngine (oscillatorEngine);
+
+    // Checked per block rather than remembered: a restored render state may predate the tables.
+    if (oscillatorEngine == OscillatorEngine::wavetable && ! tableOsc.hasTables())
+    {
+        tableOsc.setTables (sawWavetables);
+        unison.setTables (sawWavetables);
+    }
+
+    unison.setLayout (parameters->getUnisonVoices(), parameters->getUnisonDetune(), parameters->getUnisonSpread());
+
+    if (oscillatorEngine == OscillatorEngine::wavetable)
+    {
+        tableOsc.setFrequency (currentFrequency, sampleRate);
+        tableOsc.setPulseWidth (parameters->getPulseWidth());
+    }
+    else
+    {
+        pulseOsc.setFrequency (currentFrequency, sampleRate);
+        pulseOsc.setPulseWidth (parameters->getPulseWidth());
+    }
+
+    if (unison.getNumLayers() > 1)
+    {
+        unison.setFrequency (currentFrequency, sampleRate);
+        unison.setPulseWidth (parameters->getPulseWidth());
+    }
+
+    // Switching filter type mid-note: the other filter's state is stale, so start it from silence.
+    if (parameters->getFilterType() != filterType)
+    {
+        filterType = parameters->getFilterType();
+        lowPassFilter.reset();
+        svfFilter.reset();
+        lowPassFilterRight.reset();
+        svfFilterRight.reset();
+    }
+
+    // The right channel takes over from the mono filter's state, so spreading a sounding note doesn't click.
+    if (unison.isStereo() && ! renderingStereo)
+    {
+        lowPassFilterRight = lowPassFilter;
+        svfFilterRight = svfFilter;
+    }
+
+    renderingStereo = unison.isStereo();
+    expression.setRampLength (juce::roundToInt (sampleRate * expressionRampSeconds));
+    hasExpression = expression.isActive();
+    lowPassFilter.setCoefficients (parameters->getFilterCoefficients());
+    svfFilter.setCoefficients (parameters->getSvfCoefficients());
+    lowPassFilterRight.setCoefficients (parameters->getFilterCoefficients());
+    svfFilterRight.setCoefficients (parameters->getSvfCoefficients());
+    return true;
+}
+
+void AntiAliasedVoice::controllerMoved (int controllerNumber, int newControllerValue)
+{
+    if (controllerNumber == 10)
+        setPan (panFromController (newControllerValue));
+}
+
+float AntiAliasedVoice::panFromController (int controllerValue) noexcept
+{
+    return juce::jlimit (-1.0f, 1.0f, static_cast<float> (controllerValue - 64) / 63.0f);
+}
+
+void AntiAliasedVoice::prepare (int maximumBlockSize)
+{
+    scratch.setSize (3, juce::jmax (1, maximumBlockSize));
+    preciseScratch.setSize (3, juce::jmax (1, maximumBlockSize));
+    envelopeGains.resize (static_cast<size_t> (juce::jmax (1, maximumBlockSize)));
+    expressionBuffers.setSize (4, juce::jmax (1, maximumBlockSize));
+    expressionSvfRamp.resize (static_cast<size_t> (juce::jmax (1, maximumBlockSize)));
+}
+
+void AntiAliasedVoice::setRouting (const SmoothedParameters& newParameters, bool shouldApplyPartGain,
+                                   int firstChannel, int numChannels) noexcept
+{
+    parameters = &newParameters;
+    appliesPartGain = shouldApplyPartGain;
+    firstOutputChannel = juce::jmax (0, firstChannel);
+    numOutputChannels = numChannels;
+}
+
+void AntiAliasedVoice::startExpression (int midiChannel, float bendSemitones, float pressure, float slide) noexcept
+{
+    expressionChannel = midiChannel;
+    expression.reset (bendSemitones, pressure, slide);
+}
+
+void AntiAliasedVoice::setRenderState (const RenderState& state) noexcept
+{
+    pulseOsc = state.oscillator;
+    lowPassFilter = state.biquad;
+    svfFilter = state.svf;
+    envelope = state.envelope;
+    filterType = state.filterType;
+    unison = state.unison;
+    lowPassFilterRight = state.biquadRight;
+    svfFilterRight = state.svfRight;
+    renderingStereo = state.stereo;
+    tableOsc = state.tableOscillator;
+    oscillatorEngine = state.engine;
+    unison.setEngine (oscillatorEngine);
+    expression = state.expression;
+}
+
+void AntiAliasedVoice::renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+{
+    if (prepareToRender())
+        renderInto (outputBuffer, startSample, numSamples);
+}
+
+void AntiAliasedVoice::renderNextBlock (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples)
+{
+    if (prepareToRender())
+        renderInto (outputBuffer, startSample, numSamples);
+}
+
+void AntiAliasedVoice::renderPrepared (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+{
+    renderInto (outputBuffer, startSample, numSamples);
+}
+
+void AntiAliasedVoice::renderPrepared (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples)
+{
+    renderInto (outputBuffer, startSample, numSamples);
+}
+
+// Render mono through the oscillator kernel, scaling and filter, then fan the scratch buffer out to the channels.
+// A mono signal going to one or two channels, the common case, takes a fused kernel for everything after the
+// oscillator. The rest stays on the separate passes: the precise engine renders in double through its own filter
+// kernels, a spread unison stack runs a filter per side, and three or more channels are rare enough not to be worth
+// a kernel each. There is no bypass variant because the filter is never bypassed; both filter types always run.
+template <typename SampleType>
+void AntiAliasedVoice::renderInto (juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples)
+{
+    const auto scratchSize = scratch.getNumSamples();
+    if (scratchSize == 0)
+    {
+        jassertfalse;   // prepare() has not been called.
+        return;
+    }
+
+    const auto numChannels = getOutputChannels (outputBuffer.getNumChannels()).getLength();
+    const auto fused = fusedKernelsEnabled && ! highPrecision && ! renderingStereo && (numChannels == 1 || numChannels == 2);
+
+    for (int offset = 0; offset < numSamples; offset += scratchSize)
+    {
+        const auto chunkSize = juce::jmin (scratchSize, numSamples - offset);
+
+        if (fused)
+        {
+            renderFusedChunk (outputBuffer, startSample + offset, chunkSize);
+        }
+        else
+        {
+            renderToScratch (startSample + offset, chunkSize);
+            addToOutput (outputBuffer, startSample + offset, chunkSize);
+        }
+    }
+}
+
+// Touches nothing but this voice, so different voices can run it on different threads.
+void AntiAliasedVoice::renderToScratch (int startSample, int numSamples) noexcept
+{
+    jassert (numSamples <= scratch.getNumSamples());
+
+    if (highPrecision)
+    {
+        renderPreciseToScratch (startSample, numSamples);
+        return;
+    }
+
+    auto* mono = scratch.getWritePointer (0);
+    auto* right = renderingStereo ? scratch.getWritePointer (1) : nullptr;
+    const auto controls = renderOscillatorsToScratch (startSample, numSamples);
+
+    const auto level = getOutputLevel();
+
+    if (envelope.process (envelopeGains.data(), level, numSamples))
+    {
+        juce::FloatVectorOperations::multiply (mono, envelopeGains.data(), numSamples);
+
+        if (right != nullptr)
+            juce::FloatVectorOperations::multiply (right, envelopeGains.data(), numSamples);
+    }
+    else
+    {
+        juce::FloatVectorOperations::multiply (mono, level * envelope.getLevel(), numSamples);
+
+        if (right != nullptr)
+            juce::FloatVectorOperations::multiply (right, level * envelope.getLevel(), numSamples);
+    }
+
+    filterInPlace (mono, lowPassFilter, svfFilter, controls.svfRamp, numSamples);
+
+    if (right != nullptr)
+        filterInPlace (right, lowPassFilterRight, svfFilterRight, controls.svfRamp, numSamples);
+}
+
+// The float engine's oscillator stage: the raw signal into scratch, mono or left/right as renderingStereo says.
+AntiAliasedVoice::ChunkControls AntiAliasedVoice::renderOscillatorsToScratch (int startSample, int numSamples) noexcept
+{
+    auto* mono = scratch.getWritePointer (0);
+    auto* right = renderingStereo ? scratch.getWritePointer (1) : nullptr;
+    const auto controls = prepareChunk (startSample, numSamples);
+
+    if (unison.getNumLayers() > 1)
+        unison.processBlock (mono, right, controls.pulseWidths, scratch.getWritePointer (2), numSamples);
+    else if (oscillatorEngine == OscillatorEngine::wavetable)
+        renderOscillator (tableOsc, mono, controls.pulseWidths, controls.pitchRatios, numSamples);
+    else
+        renderOscillator (pulseOsc, mono, controls.pulseWidths, controls.pitchRatios, numSamples);
+
+    return controls;
+}
+
+template <typename SampleType>
+void AntiAliasedVoice::renderFusedChunk (juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples) noexcept
+{
+    jassert (numSamples <= scratch.getNumSamples());
+
+    const auto channels = getOutputChannels (outputBuffer.getNumChannels());
+    const auto numOutputs = channels.getLength();
+    const auto controls = renderOscillatorsToScratch (startSample, numSamples);
+    const auto level = getOutputLevel();
+    const auto gainIsMoving = envelope.process (envelopeGains.data(), level, numSamples);
+
+    // As mixInto() pans: only a stereo destination takes the balance gains.
+    SampleType* const outputs[] = { outputBuffer.getWritePointer (channels.getStart(), startSample),
+                                    outputBuffer.getWritePointer (channels.getEnd() - 1, startSample) };
+    const float outputGains[] = { numOutputs == 2 ? juce::jmin (1.0f, 1.0f - pan) : 1.0f,
+                                  numOutputs == 2 ? juce::jmin (1.0f, 1.0f + pan) : 1.0f };
+
+    const auto filter = filterType == VoiceFilterType::biquad ? KernelFilter::biquad
+                                                              : (controls.svfRamp != nullptr ? KernelFilter::svfRamp : KernelFilter::svf);
+    const auto kernel = getChunkKernel<SampleType> (filter, gainIsMoving, numOutputs);
+    (this->*kernel) (outputs, outputGains, level * envelope.getLevel(), controls.svfRamp, numSamples);
+}
+
+template <typename SampleType>
+AntiAliasedVoice::ChunkKernel<SampleType> AntiAliasedVoice::getChunkKernel (KernelFilter filter, bool gainIsMoving, int numOutputs) noexcept
+{
+    using F = KernelFilter;
+
+    // [filter][gain is moving][outputs - 1]
+    static constexpr ChunkKernel<SampleType> kernels[3][2][2] =
+    {
+        { { &AntiAliasedVoice::fusedKernel<SampleType, F::biquad, false, 1>,  &AntiAliasedVoice::fusedKernel<SampleType, F::biquad, false, 2> },
+          { &AntiAliasedVoice::fusedKernel<SampleType, F::biquad, true, 1>,   &AntiAliasedVoice::fusedKernel<SampleType, F::biquad, true, 2> } },
+        { { &AntiAliasedVoice::fusedKernel<SampleType, F::svf, false, 1>,     &AntiAliasedVoice::fusedKernel<SampleType, F::svf, false, 2> },
+          { &AntiAliasedVoice::fusedKernel<SampleType, F::svf, true, 1>,      &AntiAliasedVoice::fusedKernel<SampleType, F::svf, true, 2> } },
+        { { &AntiAliasedVoice::fusedKernel<SampleType, F::svfRamp, false, 1>, &AntiAliasedVoice::fusedKernel<SampleType, F::svfRamp, false, 2> },
+          { &AntiAliasedVoice::fusedKernel<SampleType, F::svfRamp, true, 1>,  &AntiAliasedVoice::fusedKernel<SampleType, F::svfRamp, true, 2> } }
+    };
+
+    jassert (numOutputs == 1 || numOutputs == 2);
+    return kernels[static_cast<int> (filter)][gainIsMoving ? 1 : 0][numOutputs - 1];
+}
+
+// The filter runs on local copies of its state and coefficients, which the output pointers can't alias, as
+// LowPassBiquad and LowPassSvf do in their own blocks.
+template <typename SampleType, AntiAliasedVoice::KernelFilter filter, bool gainIsMoving, int numOutputs>
+void AntiAliasedVoice::fusedKernel (SampleType* const* outputs, const float* outputGains, float constantGain,
+                                    const LowPassSvf::Coefficients* svfRamp, int numSamples) noexcept
+{
+    const auto* input = scratch.getReadPointer (0);
+    const auto* gains = envelopeGains.data();
+    auto* first = outputs[0];
+    auto* second = outputs[numOutputs - 1];
+    const auto firstGain = static_cast<SampleType> (outputGains[0]);
+    const auto secondGain = static_cast<SampleType> (outputGains[numOutputs - 1]);
+
+    const auto biquad = lowPassFilter;
+    const auto svfCoefficients = svfFilter.coefficients;
+    auto s1 = static_cast<float> (filter == KernelFilter::biquad ? lowPassFilter.z1 : svfFilter.ic1eq);
+    auto s2 = static_cast<float> (filter == KernelFilter::biquad ? lowPassFilter.z2 : svfFilter.ic2eq);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float sample;
+
+        if constexpr (gainIsMoving)
+            sample = input[i] * gains[i];
+        else
+            sample = input[i] * constantGain;
+
+        if constexpr (filter == KernelFilter::biquad)
+            sample = biquad.tick (sample, s1, s2);
+        else if constexpr (filter == KernelFilter::svfRamp)
+            sample = LowPassSvf::tick (sample, s1, s2, svfRamp[i]);
+        else
+            sample = LowPassSvf::tick (sample, s1, s2, svfCoefficients);
+
+        first[i] += static_cast<SampleType> (sample) * firstGain;
+
+        if constexpr (numOutputs == 2)
+            second[i] += static_cast<SampleType> (sample) * secondGain;
+    }
+
+    if constexpr (filter == KernelFilter::biquad)
+    {
+        lowPassFilter.z1 = s1;
+        lowPassFilter.z2 = s2;
+    }
+    else
+    {
+        svfFilter.ic1eq = s1;
+        svfFilter.ic2eq = s2;
+
+        if constexpr (filter == KernelFilter::svfRamp)
+            if (numSamples > 0)
+                svfFilter.coefficients = svfRamp[numSamples - 1];
+    }
+}
+
+// Same signal chain as renderToScratch(), in double throughout; addToOutput() then reads preciseScratch.
+void AntiAliasedVoice::renderPreciseToScratch (int startSample, int numSamples) noexcept
+{
+    auto* precise = preciseScratch.getWritePointer (0);
+    auto* right = renderingStereo ? preciseScratch.getWritePointer (1) : nullptr;
+    const auto controls = prepareChunk (startSample, numSamples);
+
+    if (unison.getNumLayers() > 1)
+        unison.processBlockPrecise (precise, right, controls.pulseWidths, preciseScratch.getWritePointer (2), numSamples);
+    else if (oscillatorEngine == OscillatorEngine::wavetable)
+        renderOscillator (tableOsc, precise, controls.pulseWidths, controls.pitchRatios, numSamples);
+    else
+        renderOscillator (pulseOsc, precise, controls.pulseWidths, controls.pitchRatios, numSamples);
+
+    const auto level = getOutputLevel();
+    const auto applyEnvelope = [&] (double* samples, bool isMoving)
+    {
+        if (isMoving)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] *= static_cast<double> (envelopeGains[static_cast<size_t> (i)]);
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply (samples, static_cast<double> (level * envelope.getLevel()), numSamples);
+        }
+    };
+
+    const auto isMoving = envelope.process (envelopeGains.data(), level, numSamples);
+    applyEnvelope (precise, isMoving);
+    filterInPlace (precise, lowPassFilter, svfFilter, controls.svfRamp, numSamples);
+
+    if (right != nullptr)
+    {
+        applyEnvelope (right, isMoving);
+        filterInPlace (right, lowPassFilterRight, svfFilterRight, controls.svfRamp, numSamples);
+    }
+}
+
+// Without expression the chunk reads the shared ramps. With it, the voice renders its own pulse widths, pitch
+// ratios and SVF coefficients for the chunk. The unison stack and the biquad can't follow a per-sample control,
+// so they take the bend and the slide as of the chunk's last sample instead.
+AntiAliasedVoice::ChunkControls AntiAliasedVoice::prepareChunk (int startSample, int numSamples) noexcept
+{
+    ChunkControls controls;
+    const auto* sharedWidths = parameters->getPulseWidthRamp();
+    const auto* sharedSvfRamp = parameters->getSvfCoefficientRamp();
+    controls.pulseWidths = sharedWidths != nullptr ? sharedWidths + startSample : nullptr;
+    controls.svfRamp = sharedSvfRamp != nullptr ? sharedSvfRamp + startSample : nullptr;
+
+    if (! hasExpression || numSamples <= 0)
+        return controls;
+
+    jassert (numSamples <= expressionBuffers.getNumSamples());
+    auto* ratios = expressionBuffers.getWritePointer (pitchRatioChannel);
+    auto* pressures = expressionBuffers.getWritePointer (pressureChannel);
+    auto* slides = expressionBuffers.getWritePointer (slideChannel);
+    auto* widths = expressionBuffers.getWritePointer (pulseWidthChannel);
+    expression.render (startSample, numSamples, ratios, pressures, slides);
+
+    if (controls.pulseWidths != nullptr)
+        juce::FloatVectorOperations::copy (widths, controls.pulseWidths, numSamples);
+    else
+        juce::FloatVectorOperations::fill (widths, parameters->getPulseWidth(), numSamples);
+
+    juce::FloatVectorOperations::addWithMultiply (widths, pressures, pressureToPulseWidth, numSamples);
+    controls.pulseWidths = widths;
+
+    if (unison.getNumLayers() > 1)
+        unison.setFrequency (currentFrequency * ratios[numSamples - 1], getSampleRate());
+    else
+        controls.pitchRatios = ratios;
+
+    const auto slideOffset = [&] (int i) { return slideToCutoff * (slides[i] - NoteExpression::neutralSlide); };
+
+    if (filterType == VoiceFilterType::svf)
+    {
+        const auto* cutoffs = parameters->getFilterCutoffRamp();
+        const auto constantCutoff = parameters->getFilterCutoff();
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto cutoff = cutoffs != nullptr ? cutoffs[startSample + i] : constantCutoff;
+            expressionSvfRamp[static_cast<size_t> (i)] = parameters->getSvfCoefficientsFor (cutoff - slideOffset (i));
+        }
+
+        controls.svfRamp = expressionSvfRamp.data();
+    }
+    else if (slides[numSamples - 1] != NoteExpression::neutralSlide)
+    {
+        const auto coefficients = parameters->getFilterCoefficientsFor (parameters->getFilterCutoff() - slideOffset (numSamples - 1));
+        lowPassFilter.setCoefficients (coefficients);
+        lowPassFilterRight.setCoefficients (coefficients);
+    }
+
+    return controls;
+}
+
+template <typename SampleType>
+void AntiAliasedVoice::filterInPlace (SampleType* samples, LowPassBiquad& biquad, LowPassSvf& svf,
+                                      const LowPassSvf::Coefficients* coefficientRamp, int numSamples) noexcept
+{
+    if (filterType == VoiceFilterType::biquad)
+        biquad.processBlock (samples, numSamples);
+    else if (coefficientRamp != nullptr)
+        svf.processBlock (samples, coefficientRamp, numSamples);
+    else
+        svf.processBlock (samples, numSamples);
+}
+
+void AntiAliasedVoice::addToOutput (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) const noexcept
+{
+    mixInto (outputBuffer, startSample, numSamples);
+}
+
+void AntiAliasedVoice::addToOutput (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples) const noexcept
+{
+    mixInto (outputBuffer, startSample, numSamples);
+}
+
+// The channels the voice is routed to: all of them, or one bus's in multi-timbral mode.
+juce::Range<int> AntiAliasedVoice::getOutputChannels (int numBufferChannels) const noexcept
+{
+    const auto first = juce::jmin (firstOutputChannel, numBufferChannels);
+    const auto numChannels = numOutputChannels < 0 ? numBufferChannels - first : juce::jmin (numOutputChannels, numBufferChannels - first);
+    return { first, first + numChannels };
+}
+
+// Balance law: the centre keeps unity gain on both sides, so un-panned voices sound exactly as before.
+template <typename SampleType>
+void AntiAliasedVoice::mixInto (juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples) const noexcept
+{
+    const auto channels = getOutputChannels (outputBuffer.getNumChannels());
+    const auto first = channels.getStart();
+    const auto numChannels = channels.getLength();
+    const auto output = [&] (int channel) { return outputBuffer.getWritePointer (first + channel, startSample); };
+
+    // Spread unison renders a left/right pair; a mono or multichannel output takes their average everywhere.
+    const auto mix = [&] (const auto* mono, const auto* right)
+    {
+        if (right != nullptr && numChannels == 2)
+        {
+            addScaled (output (0), mono, juce::jmin (1.0f, 1.0f - pan), numSamples);
+            addScaled (output (1), right, juce::jmin (1.0f, 1.0f + pan), numSamples);
+            return;
+        }
+
+        if (right != nullptr)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                addScaled (output (channel), mono, 0.5f, numSamples);
+                addScaled (output (channel), right, 0.5f, numSamples);
+            }
+
+            return;
+        }
+
+        if (pan == 0.0f || numChannels != 2)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                addScaled (output (channel), mono, 1.0f, numSamples);
+
+            return;
+        }
+
+        addScaled (output (0), mono, juce::jmin (1.0f, 1.0f - pan), numSamples);
+        addScaled (output (1), mono, juce::jmin (1.0f, 1.0f + pan), numSamples);
+    };
+
+    if (highPrecision)
+        mix (preciseScratch.getReadPointer (0), renderingStereo ? preciseScratch.getReadPointer (1) : nullptr);
+    else
+        mix (scratch.getReadPointer (0), renderingStereo ? scratch.getReadPointer (1) : nullptr);
+}
+
+int AntiAliasedVoice::addToBank (PulseVoiceBank& bank) const noexcept
+{
+    // The bank only produces a mono mix with one feedback-FM oscillator and level per lane, so panned voices,
+    // unison stacks, wavetable voices, voices whose envelope or expression is moving and voices of a multi-timbral part
+    // with a gain or bus of its own keep rendering through their own scratch buffer.
+    if (pan != 0.0f || envelope.isMoving() || hasExpression || unison.getNumLayers() > 1
+        || oscillatorEngine != OscillatorEngine::feedbackFm || appliesPartGain || firstOutputChannel != 0)
+        return -1;
+
+    const auto level = currentLevel * envelope.getLevel();
+
+    if (filterType == VoiceFilterType::biquad)
+        return bank.add (pulseOsc, lowPassFilter, level);
+
+    return bank.add (pulseOsc, svfFilter, level);
+}
+
+void AntiAliasedVoice::restoreFromBank (const PulseVoiceBank& bank, int lane) noexcept
+{
+    if (filterType == VoiceFilterType::biquad)
+        bank.store (lane, pulseOsc, lowPassFilter);
+    else
+        bank.store (lane, pulseOsc, svfFilter);
+}
+
+//==============================================================================
+AntiAliasedSynthesiser::~AntiAliasedSynthesiser()
+{
+    // The pool owns the voices, so the base class must not delete them.
+    voices.clear (false);
+
+    for (int i = 0; i < poolCapacity; ++i)
+        voicePool[i].~AntiAliasedVoice();
+
+    std::allocator<AntiAliasedVoice>().deallocate (voicePool, static_cast<size_t> (poolCapacity));
+}
+
+void AntiAliasedSynthesiser::createVoicePool (const SmoothedParameters& sharedParameters, const SharedTables& sharedTables, int capacity)
+{
+    jassert (voicePool == nullptr && voices.isEmpty());
+    parameters = &sharedParameters;
+
+    poolCapacity = juce::jmax (1, capacity);
+    voicePool = std::allocator<AntiAliasedVoice>().allocate (static_cast<size_t> (poolCapacity));
+
+    for (int i = 0; i < poolCapacity; ++i)
+        addVoice (new (voicePool + i) AntiAliasedVoice (sharedParameters, sharedTables));
+
+    activeVoices.reserve (static_cast<size_t> (poolCapacity));
+    scheduledVoices.reserve (static_cast<size_t> (poolCapacity));
+    renderPositions.assign (static_cast<size_t> (poolCapacity), 0);
+    savedVoiceStates.resize (static_cast<size_t> (poolCapacity));
+    allocator.prepare (poolCapacity);
+    numEnabledVoices = poolCapacity;
+}
+
+void AntiAliasedSynthesiser::setNumEnabledVoices (int numVoices)
+{
+    numVoices = juce::jlimit (1, juce::jmax (1, poolCapacity), numVoices);
+
+    if (numVoices == numEnabledVoices)
+        return;
+
+    const juce::ScopedLock sl (lock);
+
+    for (int i = numVoices; i < numEnabledVoices; ++i)
+        if (voicePool[i].isVoiceActive())
+            stopVoice (voicePool + i, 0.0f, false);
+
+    // Once retired, every idle slot is off the active list, so the idle enabled ones are exactly the free ones.
+    retireFinishedVoices();
+    numEnabledVoices = numVoices;
+    allocator.setNumEnabledSlots (numVoices);
+
+    for (int i = numVoices; --i >= 0;)
+        if (! voicePool[i].isVoiceActive())
+            allocator.addFreeSlot (i);
+}
+
+void AntiAliasedSynthesiser::prepare (double sampleRate, int maximumBlockSize)
+{
+    setCurrentPlaybackSampleRate (sampleRate);
+    setRenderSampleRate (sampleRate);   // The base class skips the voices if its own rate is unchanged.
+
+    const juce::ScopedLock sl (lock);
+    bank.prepare (poolCapacity);
+    bankVoices.assign (static_cast<size_t> (bank.getCapacity()), nullptr);
+    bankMix.setSize (1, juce::jmax (1, maximumBlockSize));
+    preparedVoices.assign (static_cast<size_t> (poolCapacity), nullptr);
+    preparedBlockSize = juce::jmax (1, maximumBlockSize);
+    shortestControllerRun.store (0, std::memory_order_relaxed);
+
+    for (int i = 0; i < poolCapacity; ++i)
+        voicePool[i].prepare (maximumBlockSize);
+}
+
+void AntiAliasedSynthesiser::setRenderSampleRate (double newSampleRate)
+{
+    const juce::ScopedLock sl (lock);
+
+    for (int i = 0; i < poolCapacity; ++i)
+        voicePool[i].setCurrentPlaybackSampleRate (newSampleRate);
+}
+
+void AntiAliasedSynthesiser::setHighPrecision (bool shouldUseHighPrecision)
+{
+    const juce::ScopedLock sl (lock);
+    highPrecision = shouldUseHighPrecision;
+
+    for (int i = 0; i < poolCapacity; ++i)
+        voicePool[i].setHighPrecision (shouldUseHighPrecision);
+}
+
+void AntiAliasedSynthesiser::saveVoiceStates() noexcept
+{
+    for (int i = 0; i < poolCapacity; ++i)
+        savedVoiceStates[static_cast<size_t> (i)] = voicePool[i].getRenderState();
+}
+
+void AntiAliasedSynthesiser::restoreVoiceStates() noexcept
+{
+    for (int i = 0; i < poolCapacity; ++i)
+        voicePool[i].setRenderState (savedVoiceStates[static_cast<size_t> (i)]);
+}
+
+void AntiAliasedSynthesiser::handleController (int midiChannel, int controllerNumber, int controllerValue)
+{
+    if (controllerNumber == 10 && midiChannel >= 1 && midiChannel <= 16)
+        channelPans[static_cast<size_t> (midiChannel - 1)] = AntiAliasedVoice::panFromController (controllerValue);
+
+    // Over 128 rather than 127, so 64 sits exactly at neutral and a centred slide renders nothing.
+    if (controllerNumber == 74 && midiChannel >= 1 && midiChannel <= 16)
+    {
+        channelSlideOffsets[static_cast<size_t> (midiChannel - 1)] = (static_cast<float> (controllerValue) / 128.0f) - NoteExpression::neutralSlide;
+        sendExpression (midiChannel, NoteExpression::slide);
+    }
+
+    juce::Synthesiser::handleController (midiChannel, controllerNumber, controllerValue);
+}
+
+// The voices ignore pitchWheelMoved(), so the base class's pass over every voice is skipped.
+void AntiAliasedSynthesiser::handlePitchWheel (int midiChannel, int wheelValue)
+{
+    if (midiChannel < 1 || midiChannel > 16)
+        return;
+
+    channelBends[static_cast<size_t> (midiChannel - 1)] = juce::jlimit (-1.0f, 1.0f, static_cast<float> (wheelValue - 8192) / 8192.0f);
+    sendExpression (midiChannel, NoteExpression::pitchBend);
+}
+
+void AntiAliasedSynthesiser::handleChannelPressure (int midiChannel, int channelPressureValue)
+{
+    if (midiChannel < 1 || midiChannel > 16)
+        return;
+
+    channelPressures[static_cast<size_t> (midiChannel - 1)] = static_cast<float> (channelPressureValue) / 127.0f;
+    sendExpression (midiChannel, NoteExpression::pressure);
+}
+
+void AntiAliasedSynthesiser::handleAftertouch (int midiChannel, int midiNoteNumber, int aftertouchValue)
+{
+    if (auto* voice = getVoiceForNote (midiChannel, midiNoteNumber))
+        voice->addExpression (NoteExpression::pressure, static_cast<float> (aftertouchValue) / 127.0f, eventPosition);
+}
+
+bool AntiAliasedSynthesiser::isExpressionMessage (const juce::MidiMessage& message) noexcept
+{
+    return message.isPitchWheel() || message.isChannelPressure() || message.isAftertouch()
+        || (message.isController() && message.getControllerNumber() == 74);
+}
+
+void AntiAliasedSynthesiser::setChannelRouting (int midiChannel, const ChannelRouting& routing) noexcept
+{
+    if (midiChannel >= 1 && midiChannel <= 16)
+        channelRoutings[static_cast<size_t> (midiChannel - 1)] = routing;
+}
+
+float AntiAliasedSynthesiser::getBendSemitones (int midiChannel) const noexcept
+{
+    if (multiTimbral)
+        return channelBends[static_cast<size_t> (midiChannel - 1)] * masterBendRange;
+
+    const auto master = channelBends[static_cast<size_t> (mpeMasterChannel - 1)] * masterBendRange;
+
+    if (midiChannel == mpeMasterChannel)
+        return master;
+
+    return master + (channelBends[static_cast<size_t> (midiChannel - 1)] * parameters->getMpeBendRange());
+}
+
+// Queued at the event's own sample, for the voices the channel reaches; they render it without a catch-up.
+void AntiAliasedSynthesiser::sendExpression (int midiChannel, NoteExpression::Dimension dimension) noexcept
+{
+    const auto reachesEveryVoice = dimension == NoteExpression::pitchBend && midiChannel == mpeMasterChannel && ! multiTimbral;
+
+    for (auto* voice : activeVoices)
+    {
+        const auto channel = voice->getExpressionChannel();
+
+        if (channel != midiChannel && ! reachesEveryVoice)
+            continue;
+
+        const auto index = static_cast<size_t> (channel - 1);
+        const auto value = dimension == NoteExpression::pitchBend ? getBendSemitones (channel)
+                         : dimension == NoteExpression::pressure  ? channelPressures[index]
+                                                                  : NoteExpression::neutralSlide + channelSlideOffsets[index];
+        voice->addExpression (dimension, value, eventPosition);
+    }
+}
+
+// Replaces the base class's note-on, which scans every voice twice. One voice per key: the first sound that
+// applies plays it, on the voice the allocator picks.
+void AntiAliasedSynthesiser::noteOn (int midiChannel, int midiNoteNumber, float velocity)
+{
+    const juce::ScopedLock sl (lock);
+
+    juce::SynthesiserSound* sound = nullptr;
+
+    for (auto* candidate : sounds)
+    {
+        if (candidate->appliesToNote (midiNoteNumber) && candidate->appliesToChannel (midiChannel))
+        {
+            sound = candidate;
+            break;
+        }
+    }
+
+    if (sound == nullptr)
+        return;
+
+    auto* started = chooseVoice (midiChannel, midiNoteNumber, isNoteStealingEnabled());
+
+    if (started == nullptr)
+        return;
+
+    if (started->isVoiceActive())
+        started->carryStateIntoNextNote();
+
+    allocator.assign (static_cast<int> (started - voicePool), midiChannel, midiNoteNumber);
+
+    if (midiChannel >= 1 && midiChannel <= 16)
+    {
+        const auto& routing = channelRoutings[static_cast<size_t> (midiChannel - 1)];
+        started->setRouting (routing.parameters != nullptr ? *routing.parameters : *parameters, routing.appliesPartGain,
+                             routing.firstOutputChannel, routing.numOutputChannels);
+    }
+
+    startVoice (started, sound, midiChannel, midiNoteNumber, velocity);
+
+    // Pool slots are contiguous, so pointer order is slot order.
+    const auto position = std::lower_bound (activeVoices.begin(), activeVoices.end(), started);
+    auto& renderPosition = renderPositions[static_cast<size_t> (started - voicePool)];
+
+    if (position == activeVoices.end() || *position != started)
+    {
+        activeVoices.insert (position, started);
+        renderPosition = eventPosition;
+    }
+    else
+    {
+        renderPosition = juce::jmax (renderPosition, eventPosition);   // A reused voice may already be past the event.
+    }
+
+    if (midiChannel >= 1 && midiChannel <= 16)
+    {
+        const auto index = static_cast<size_t> (midiChannel - 1);
+        started->setPan (channelPans[index]);
+        started->startExpression (midiChannel, getBendSemitones (midiChannel), channelPressures[index],
+                                  NoteExpression::neutralSlide + channelSlideOffsets[index]);
+    }
+}
+
+// The base class's note-off, for the one voice the key maps to instead of every voice.
+void AntiAliasedSynthesiser::noteOff (int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff)
+{
+    const juce::ScopedLock sl (lock);
+    auto* voice = getVoiceForNote (midiChannel, midiNoteNumber);
+
+    if (voice == nullptr || voice->getCurrentlyPlayingNote() != midiNoteNumber || ! voice->isPlayingChannel (midiChannel))
+        return;
+
+    voice->setKeyDown (false);
+
+    if (! (voice->isSustainPedalDown() || voice->isSostenutoPedalDown()))
+        stopVoice (voice, velocity, allowTailOff);
+}
+
+AntiAliasedVoice* AntiAliasedSynthesiser::getVoiceForNote (int midiChannel, int midiNoteNumber) const noexcept
+{
+    const auto slot = allocator.getSlotForNote (midiChannel, midiNoteNumber);
+    return slot >= 0 ? voicePool + slot : nullptr;
+}
+
+// The voice already on the key, else a free slot, else a steal. Free slots only come back when finished voices
+// are retired, which normally happens once per block; it is done early here rather than steal needlessly.
+AntiAliasedVoice* AntiAliasedSynthesiser::chooseVoice (int midiChannel, int midiNoteNumber, bool stealIfNoneAvailable) noexcept
+{
+    if (auto* voice = getVoiceForNote (midiChannel, midiNoteNumber))
+        return voice;
+
+    if (allocator.getFreeSlot() < 0)
+        retireFinishedVoices();
+
+    if (const auto slot = allocator.getFreeSlot(); slot >= 0)
+        return voicePool + slot;
+
+    return stealIfNoneAvailable ? chooseVoiceToSteal() : nullptr;
+}
+
+// Only runs with every enabled slot sounding, so the active list is exactly the candidates.
+AntiAliasedVoice* AntiAliasedSynthesiser::chooseVoiceToSteal() const noexcept
+{
+    AntiAliasedVoice* best = nullptr;
+
+    for (auto* voice : activeVoices)
+    {
+        if (voice - voicePool >= numEnabledVoices)
+            continue;
+
+        if (best == nullptr)
+        {
+            best = voice;
+            continue;
+        }
+
+        if (stealingPolicy == StealingPolicy::quietest)
+        {
+            const auto amplitude = voice->getCurrentAmplitude();
+            const auto bestAmplitude = best->getCurrentAmplitude();
+
+            if (amplitude < bestAmplitude || (amplitude == bestAmplitude && voice->wasStartedBefore (*best)))
+                best = voice;
+        }
+        else if (voice->isKeyDown() == best->isKeyDown() ? voice->wasStartedBefore (*best) : best->isKeyDown())
+        {
+            best = voice;
+        }
+    }
+
+    return best;
+}
+
+void AntiAliasedSynthesiser::retireFinishedVoices() noexcept
+{
+    auto kept = activeVoices.begin();
+
+    for (auto* voice : activeVoices)
+    {
+        if (voice->isVoiceActive())
+            *kept++ = voice;
+        else
+            allocator.release (static_cast<int> (voice - voicePool));
+    }
+
+    activeVoices.erase (kept, activeVoices.end());
+}
+
+void AntiAliasedSynthesiser::setNumRenderWorkers (int numWorkers)
+{
+    renderPool.setNumWorkers (numWorkers);
+}
+
+void AntiAliasedSynthesiser::renderNextBlock (juce::AudioBuffer<float>& outputAudio, const juce::MidiBuffer& inputMidi,
+                                              int startSample, int numSamples)
+{
+    renderScheduled (outputAudio, inputMidi, startSample, numSamples);
+}
+
+void AntiAliasedSynthesiser::renderNextBlock (juce::AudioBuffer<double>& outputAudio, const juce::MidiBuffer& inputMidi,
+                                              int startSample, int numSamples)
+{
+    renderScheduled (outputAudio, inputMidi, startSample, numSamples);
+}
+
+// Each voice keeps its own render position within the block. An event first brings the voices it can change up
+// to its sample, so their runs end exactly there, and leaves every other voice alone.
+template <typename SampleType>
+void AntiAliasedSynthesiser::renderScheduled (juce::AudioBuffer<SampleType>& outputAudio, const juce::MidiBuffer& inputMidi,
+                                              int startSample, int numSamples)
+{
+    const juce::ScopedLock sl (lock);
+    const auto endSample = startSample + numSamples;
+
+    retireFinishedVoices();
+
+    if (const auto fused = fusedKernelsEnabled.load(); fused != voicesUseFusedKernels)
+    {
+        for (int i = 0; i < poolCapacity; ++i)
+            voicePool[i].setFusedKernelsEnabled (fused);
+
+        voicesUseFusedKernels = fused;
+    }
+
+    for (auto* voice : activeVoices)
+    {
+        renderPositions[static_cast<size_t> (voice - voicePool)] = startSample;
+        voice->beginExpressionBlock();
+    }
+
+    auto lastSplit = startSample;
+    auto shortestRun = 0;
+
+    for (auto it = inputMidi.findNextSamplePosition (startSample); it != inputMidi.end(); ++it)
+    {
+        const auto event = *it;
+
+        if (event.samplePosition >= endSample)
+            break;
+
+        const auto message = event.getMessage();
+        const auto isExpression = isExpressionMessage (message);
+
+        // No event takes effect before a controller that precedes it, even one delayed past the event's own sample:
+        // a voice a note starts renders from the controller's position, already with the new value, and a later
+        // controller joins the delayed one at its split rather than cutting a run behind it.
+        eventPosition = isExpression ? event.samplePosition : juce::jmax (event.samplePosition, lastSplit);
+
+        if (message.isNoteOn())
+        {
+            // Only the voice the allocator will hand the note to can change: the one already on the key, or the
+            // one about to be stolen. noteOn() then makes the same choice; if the catch-up ran the voice out, it
+            // is retired and, being the only one rendered, is still the one picked.
+            auto* voice = chooseVoice (message.getChannel(), message.getNoteNumber(), isNoteStealingEnabled());
+
+            if (voice != nullptr && voice->isVoiceActive())
+                catchUp (*voice, outputAudio, eventPosition);
+        }
+        else if (message.isNoteOff())
+        {
+            if (auto* voice = getVoiceForNote (message.getChannel(), message.getNoteNumber()))
+                catchUp (*voice, outputAudio, eventPosition);
+        }
+        else if (! isExpression)   // Expression is queued at its sample; nothing renders up to it.
+        {
+            // Controllers, pitch wheel, pedals and the like reach every voice; runs shorter than the minimum are
+            // avoided by applying the event at the end of the run instead. Only the block's end may cut one short.
+            if (eventPosition > lastSplit)
+            {
+                eventPosition = juce::jmin (endSample, juce::jmax (eventPosition, lastSplit + minimumSubBlockSize));
+
+                if (eventPosition < endSample)
+                    shortestRun = shortestRun == 0 ? eventPosition - lastSplit : juce::jmin (shortestRun, eventPosition - lastSplit);
+            }
+
+            catchUpAll (outputAudio, eventPosition);
+            lastSplit = eventPosition;
+        }
+
+        handleMidiEvent (message);
+    }
+
+    eventPosition = startSample;
+
+    if (const auto previous = shortestControllerRun.load (std::memory_order_relaxed);
+        shortestRun > 0 && (previous == 0 || shortestRun < previous))
+        shortestControllerRun.store (shortestRun, std::memory_order_relaxed);
+
+    // Whatever is left: voices no event touched render the whole block together, the others from where they stopped.
+    scheduledVoices.clear();
+
+    for (auto* voice : activeVoices)
+    {
+        const auto position = renderPositions[static_cast<size_t> (voice - voicePool)];
+
+        if (position == startSample)
+            scheduledVoices.push_back (voice);
+        else if (position < endSample)
+            voice->renderNextBlock (outputAudio, position, endSample - position);
+    }
+
+    renderVoiceList (outputAudio, scheduledVoices, startSample, numSamples);
+
+    // Voices that ran out during the block free their slots now, so an idle synth reports no voices straight away.
+    retireFinishedVoices();
+    numActiveVoices.store (static_cast<int> (activeVoices.size()), std::memory_order_relaxed);
+}
+
+template <typename SampleType>
+void AntiAliasedSynthesiser::catchUp (AntiAliasedVoice& voice, juce::AudioBuffer<SampleType>& outputAudio, int position)
+{
+    auto& renderPosition = renderPositions[static_cast<size_t> (&voice - voicePool)];
+
+    if (position <= renderPosition)
+        return;
+
+    voice.renderNextBlock (outputAudio, renderPosition, position - renderPosition);
+    renderPosition = position;
+}
+
+template <typename SampleType>
+void AntiAliasedSynthesiser::catchUpAll (juce::AudioBuffer<SampleType>& outputAudio, int position)
+{
+    for (auto* voice : activeVoices)
+        catchUp (*voice, outputAudio, position);
+}
+
+void AntiAliasedSynthesiser::renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    retireFinishedVoices();
+    renderVoiceList (outputAudio, activeVoices, startSample, numSamples);
+}
+
+void AntiAliasedSynthesiser::renderVoices (juce::AudioBuffer<double>& outputAudio, int startSample, int numSamples)
+{
+    retireFinishedVoices();
+    renderVoiceList (outputAudio, activeVoices, startSample, numSamples);
+}
+
+template <typename SampleType>
+void AntiAliasedSynthesiser::renderVoiceList (juce::AudioBuffer<SampleType>& outputAudio, const std::vector<AntiAliasedVoice*>& voicesToRender,
+                                              int startSample, int numSamples)
+{
+    // Every voice is set up for the run once, here; the paths below only see the ones with something to play.
+    auto numPrepared = 0;
+
+    for (auto* voice : voicesToRender)
+        if (voice->prepareToRender())
+            preparedVoices[static_cast<size_t> (numPrepared++)] = voice;
+
+    // Below minVoicesForParallelRender the hand-off costs more than it saves; the single-threaded paths take over.
+    if (renderPool.getNumWorkers() > 0 && numPrepared >= minVoicesForParallelRender)
+    {
+        renderVoicesInParallel (outputAudio, numPrepared, startSample, numSamples);
+        return;
+    }
+
+    if (! voiceBankEnabled.load() || bankVoices.empty() || highPrecision)
+    {
+        for (int i = 0; i < numPrepared; ++i)
+            preparedVoices[static_cast<size_t> (i)]->renderPrepared (outputAudio, startSample, numSamples);
+
+        return;
+    }
+
+    bank.clear();
+
+    for (int i = 0; i < numPrepared; ++i)
+    {
+        auto& pulseVoice = *preparedVoices[static_cast<size_t> (i)];
+
+        // The bank runs on the synth's own parameters; a multi-timbral part's voices play theirs.
+        const auto lane = &pulseVoice.getParameters() == parameters ? pulseVoice.addToBank (bank) : -1;
+
+        if (lane >= 0)
+            bankVoices[static_cast<size_t> (lane)] = &pulseVoice;
+        else
+            pulseVoice.renderPrepared (outputAudio, startSample, numSamples);   // Panned, a part, or more voices than lanes.
+    }
+
+    if (bank.getNumVoices() == 0)
+        return;
+
+    auto* mix = bankMix.getWritePointer (0);
+    const auto* pulseWidths = parameters->getPulseWidthRamp();
+    const auto* svfRamp = parameters->getSvfCoefficientRamp();
+    const auto useSvf = parameters->getFilterType() == VoiceFilterType::svf;
+
+    // Banked voices are mixed like channel 1's notes: everywhere, or into the main bus.
+    const auto mainChannels = channelRoutings.front().numOutputChannels;
+    const auto numBankChannels = mainChannels < 0 ? outputAudio.getNumChannels() : juce::jmin (mainChannels, outputAudio.getNumChannels());
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        const auto chunk = juce::jmin (numSamples - offset, bankMix.getNumSamples());
+        juce::FloatVectorOperations::clear (mix, chunk);
+        const auto* chunkWidths = pulseWidths != nullptr ? pulseWidths + startSample + offset : nullptr;
+
+        if (useSvf)
+            bank.process (mix, chunkWidths, parameters->getSvfCoefficients(),
+                          svfRamp != nullptr ? svfRamp + startSample + offset : nullptr, chunk);
+        else
+            bank.process (mix, chunkWidths, chunk);
+
+        for (int channel = 0; channel < numBankChannels; ++channel)
+            addScaled (outputAudio.getWritePointer (channel, startSample + offset), mix, 1.0f, chunk);
+
+        offset += chunk;
+    }
+
+    for (int lane = 0; lane < bank.getNumVoices(); ++lane)
+        bankVoices[static_cast<size_t> (lane)]->restoreFromBank (bank, lane);
+}
+
+template <typename SampleType>
+void AntiAliasedSynthesiser::renderVoicesInParallel (juce::AudioBuffer<SampleType>& outputAudio, int numActive, int startSample, int numSamples)
+{
+    for (int offset = 0; offset < numSamples; offset += preparedBlockSize)
+    {
+        parallelChunkStart = startSample + offset;
+        parallelChunkSize = juce::jmin (preparedBlockSize, numSamples - offset);
+
+        renderPool.run ([] (void* context, int index) noexcept
+                        {
+                            auto& self = *static_cast<AntiAliasedSynthesiser*> (context);
+                            self.preparedVoices[static_cast<size_t> (index)]->renderToScratch (self.parallelChunkStart, self.parallelChunkSize);
+                        },
+                        this, numActive);
+
+        // Deterministic reduction: voices are summed in slot order, whichever thread rendered them.
+        for (int i = 0; i < numActive; ++i)
+            preparedVoices[static_cast<size_t> (i)]->addToOutput (outputAudio, startSample + offset, parallelChunkSize);
+    }
+}
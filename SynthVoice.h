@@ -0,0 +1,383 @@
+#pragma once
+
+#include "Envelope.h"
+#include "NoteExpression.h"
+#include "Oscillators.h"
+#include "ParallelRenderPool.h"
+#include "PulseVoiceBank.h"
+#include "SharedTables.h"
+#include "SmoothedParameters.h"
+#include "UnisonOscillator.h"
+#include "VoiceAllocator.h"
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// This lightweight Sound object lets every custom voice respond to all incoming MIDI notes/channels.
+class AntiAliasedSound final : public juce::SynthesiserSound
+{
+public:
+    bool appliesToNote (int) override    { return true; }
+    bool appliesToChannel (int) override { return true; }
+};
+
+//==============================================================================
+// Cache-line aligned so neighbouring voices in AntiAliasedSynthesiser's pool never share a line.
+// With more than one unison voice the note plays a UnisonOscillator stack instead of its single oscillator; the
+// stack shares the note's envelope and filter, which runs a second state for the right channel once the layers
+// are spread. The Oscillator parameter picks, per block, between the feedback-FM oscillators and wavetable ones;
+// until the process-wide wavetables have been built, the wavetable engine plays the feedback-FM oscillators.
+//
+// Per-note expression (MPE) bends the pitch, moves the pulse width with pressure and the cutoff with slide. It
+// arrives as per-sample buffers rendered from a NoteExpression; voices with all three at rest skip them entirely.
+class alignas (64) AntiAliasedVoice final : public juce::SynthesiserVoice
+{
+public:
+    AntiAliasedVoice (const SmoothedParameters& sharedParameters, const SharedTables& sharedTables);
+
+    bool canPlaySound (juce::SynthesiserSound* sound) override;
+    void startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound*, int) override;
+    void stopNote (float, bool allowTailOff) override;
+    void pitchWheelMoved (int) override {}
+    void controllerMoved (int controllerNumber, int newControllerValue) override;
+    void renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
+    void renderNextBlock (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples) override;
+
+    // renderNextBlock() for a voice whose prepareToRender() has already returned true for this run.
+    void renderPrepared (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples);
+    void renderPrepared (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples);
+
+    // Sizes the mono scratch buffer the voice renders into before fanning out to the output channels.
+    void prepare (int maximumBlockSize);
+
+    // The two halves of renderNextBlock(), for callers that render many voices before mixing them:
+    // renderToScratch() needs a prior prepareToRender() and at most the prepared block size; startSample is the
+    // position within the processor's block, used to index the shared parameter ramps.
+    void renderToScratch (int startSample, int numSamples) noexcept;
+    void addToOutput (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) const noexcept;
+    void addToOutput (juce::AudioBuffer<double>& outputBuffer, int startSample, int numSamples) const noexcept;
+
+    // -1 = left, 0 = centre, 1 = right. Centred voices add the same mono signal to every channel.
+    void setPan (float newPan) noexcept  { pan = juce::jlimit (-1.0f, 1.0f, newPan); }
+    float getPan() const noexcept        { return pan; }
+    static float panFromController (int controllerValue) noexcept;
+
+    // Pulls this block's shared parameters into the oscillator/filter; returns false when the voice has nothing to
+    // render. A voice whose release has run out is retired here, and one held at a zero sustain level is skipped.
+    bool prepareToRender() noexcept;
+
+    // Voice-bank hooks: copy this voice into a SIMD lane after prepareToRender(), and take the state back afterwards.
+    int addToBank (PulseVoiceBank& bank) const noexcept;
+    void restoreFromBank (const PulseVoiceBank& bank, int lane) noexcept;
+
+    // Render engine: the oscillator and filter run in double with std::sin, into a double scratch buffer
+    // that a double-precision output takes without rounding.
+    void setHighPrecision (bool shouldUseHighPrecision) noexcept { highPrecision = shouldUseHighPrecision; }
+    bool isHighPrecision() const noexcept                        { return highPrecision; }
+
+    // Fused kernels: see renderFusedChunk(). Off, every chunk takes the separate passes, for comparison.
+    void setFusedKernelsEnabled (bool shouldBeEnabled) noexcept  { fusedKernelsEnabled = shouldBeEnabled; }
+
+    // Everything renderToScratch() advances, so a block can be rendered twice from the same starting point.
+    struct RenderState
+    {
+        AntiAliasedPulseOscillator oscillator;
+        LowPassBiquad biquad;
+        LowPassSvf svf;
+        SegmentEnvelope envelope;
+        VoiceFilterType filterType = VoiceFilterType::svf;
+        UnisonOscillator unison;
+        LowPassBiquad biquadRight;
+        LowPassSvf svfRight;
+        bool stereo = false;
+        WavetablePulseOscillator tableOscillator;
+        OscillatorEngine engine = OscillatorEngine::feedbackFm;
+        NoteExpression expression;
+    };
+
+    RenderState getRenderState() const noexcept
+    {
+        return { pulseOsc, lowPassFilter, svfFilter, envelope, filterType, unison, lowPassFilterRight, svfFilterRight, renderingStereo,
+                 tableOsc, oscillatorEngine, expression };
+    }
+
+    void setRenderState (const RenderState& state) noexcept;
+
+    // Makes the next hard stop and start a handover: a stolen or retriggered voice keeps its oscillator phase,
+    // filter state and envelope level, and attacks the new note from there instead of clicking to silence.
+    void carryStateIntoNextNote() noexcept                   { carryOverState = true; }
+
+    // The parameters and output channels of the voice's next note; -1 channels means every output channel. With
+    // shouldApplyPartGain the parameters' gain scales the voice, for a part whose gain isn't the output's.
+    void setRouting (const SmoothedParameters& newParameters, bool shouldApplyPartGain, int firstChannel, int numChannels) noexcept;
+    const SmoothedParameters& getParameters() const noexcept { return *parameters; }
+
+    // MPE: the note's channel and starting expression, taken without a ramp; call once the note has started.
+    void startExpression (int midiChannel, float bendSemitones, float pressure, float slide) noexcept;
+    int getExpressionChannel() const noexcept                { return expressionChannel; }
+
+    // Queues a change at samplePosition in the current block, which the voice renders from without splitting it.
+    void addExpression (NoteExpression::Dimension dimension, float value, int samplePosition) noexcept
+    {
+        expression.addEvent (dimension, value, samplePosition);
+    }
+
+    void beginExpressionBlock() noexcept                     { expression.beginBlock(); }
+
+    // Velocity times envelope as of the last rendered sample; 0 when idle.
+    float getCurrentAmplitude() const noexcept               { return isActive ? currentLevel * envelope.getLevel() : 0.0f; }
+
+private:
+    void renderPreciseToScratch (int startSample, int numSamples) noexcept;
+    template <typename SampleType>
+    void renderInto (juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples);
+    template <typename SampleType>
+    void mixInto (juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples) const noexcept;
+    template <typename SampleType>
+    void filterInPlace (SampleType* samples, LowPassBiquad& biquad, LowPassSvf& svf,
+                        const LowPassSvf::Coefficients* coefficientRamp, int numSamples) noexcept;
+
+    // What one chunk renders from: the shared ramps, or with expression the voice's own buffers. Null = constant.
+    struct ChunkControls
+    {
+        const float* pulseWidths = nullptr;
+        const float* pitchRatios = nullptr;
+        const LowPassSvf::Coefficients* svfRamp = nullptr;
+    };
+
+    ChunkControls prepareChunk (int startSample, int numSamples) noexcept;
+    ChunkControls renderOscillatorsToScratch (int startSample, int numSamples) noexcept;
+    juce::Range<int> getOutputChannels (int numBufferChannels) const noexcept;
+
+    // The float engine's envelope gain, filter and mix in one pass over the oscillator's output, instead of three
+    // passes over the scratch buffer. Each kernel is compiled for one filter, a moving or constant gain and a mono
+    // or stereo destination, so its loop has no branches; renderFusedChunk() picks one per chunk from a table.
+    // The arithmetic is the separate passes', in the same order, so the output is bit for bit the same.
+    enum class KernelFilter { biquad, svf, svfRamp };
+
+    template <typename SampleType>
+    using ChunkKernel = void (AntiAliasedVoice::*) (SampleType* const* outputs, const float* outputGains, float constantGain,
+                                                    const LowPassSvf::Coefficients* svfRamp, int numSamples) noexcept;
+
+    template <typename SampleType, KernelFilter filter, bool gainIsMoving, int numOutputs>
+    void fusedKernel (SampleType* const* outputs, const float* outputGains, float constantGain,
+                      const LowPassSvf::Coefficients* svfRamp, int numSamples) noexcept;
+    template <typename SampleType>
+    static ChunkKernel<SampleType> getChunkKernel (KernelFilter filter, bool gainIsMoving, int numOutputs) noexcept;
+    template <typename SampleType>
+    void renderFusedChunk (juce::AudioBuffer<SampleType>& outputBuffer, int startSample, int numSamples) noexcept;
+
+    // Expression depths: full pressure narrows the pulse by 0.4, and slide moves the cutoff control by up to
+    // half its range either way of centre. Changes ramp over a few milliseconds.
+    static constexpr float pressureToPulseWidth = 0.4f;
+    static constexpr float slideToCutoff = 1.0f;
+    static constexpr double expressionRampSeconds = 0.003;
+    static constexpr int pitchRatioChannel = 0, pressureChannel = 1, slideChannel = 2, pulseWidthChannel = 3;
+
+    float getOutputLevel() const noexcept                    { return appliesPartGain ? currentLevel * parameters->getGain() : currentLevel; }
+
+    const SmoothedParameters* parameters;
+    const SharedTables& tables;
+    AntiAliasedPulseOscillator pulseOsc;
+    float currentLevel = 0.0f;
+    float currentFrequency = 0.0f;
+    bool isActive = false;
+    LowPassBiquad lowPassFilter;
+    LowPassSvf svfFilter;
+    VoiceFilterType filterType = VoiceFilterType::svf;
+    SegmentEnvelope envelope;
+    UnisonOscillator unison;                    // Plays instead of pulseOsc with more than one unison voice.
+    LowPassBiquad lowPassFilterRight;           // Right-channel filter state while the unison layers are spread.
+    LowPassSvf svfFilterRight;
+    bool renderingStereo = false;               // As set up by the last prepareToRender().
+    WavetablePulseOscillator tableOsc;          // Plays instead of pulseOsc with the wavetable engine.
+    OscillatorEngine oscillatorEngine = OscillatorEngine::feedbackFm;   // As set up by the last prepareToRender().
+    float pan = 0.0f;
+    bool highPrecision = false;
+    bool fusedKernelsEnabled = true;
+    bool carryOverState = false;
+    NoteExpression expression;
+    int expressionChannel = 1;
+    bool appliesPartGain = false;
+    int firstOutputChannel = 0;
+    int numOutputChannels = -1;
+    bool hasExpression = false;                 // As set up by the last prepareToRender().
+    juce::AudioBuffer<float> scratch;   // Left/mono and right render targets plus unison workspace, allocated in prepare().
+    juce::AudioBuffer<double> preciseScratch;   // The high-precision kernels' targets, plus one channel of unison workspace.
+    std::vector<float> envelopeGains;           // Velocity times envelope, per sample, while the envelope moves.
+    juce::AudioBuffer<float> expressionBuffers;   // Per chunk: pitch ratios, pressures, slides and the pulse widths they give.
+    std::vector<LowPassSvf::Coefficients> expressionSvfRamp;   // Per chunk, with slide applied.
+};
+
+//==============================================================================
+// juce::Synthesiser with an optional voice-bank mode: instead of rendering voices one by one, every active
+// centred AntiAliasedVoice is gathered into a PulseVoiceBank and stepped in SIMD lanes. With render workers
+// and enough voices sounding, voices are instead rendered on several threads and mixed in slot order.
+//
+// Voices live in one contiguous pool created up front; polyphony only enables or disables its leading slots.
+// Rendering walks a list of the sounding voices, so idle and disabled slots cost nothing per block. Note-on and
+// note-off find their voice through a VoiceAllocator instead of scanning: a retriggered note reuses the voice
+// already on it, a new one takes a free slot, and only with every enabled slot sounding is a voice stolen.
+// Float and double output buffers share one templated render path; only the final mix differs in type.
+class AntiAliasedSynthesiser final : public juce::Synthesiser
+{
+public:
+    AntiAliasedSynthesiser() = default;
+    ~AntiAliasedSynthesiser() override;
+
+    // Constructs every voice the synth can ever use in one block; call once, before prepare().
+    // The voices read the parameters and tables but never own them; both must outlive the synth.
+    void createVoicePool (const SmoothedParameters& sharedParameters, const SharedTables& sharedTables, int capacity);
+    int getVoicePoolCapacity() const noexcept { return poolCapacity; }
+
+    // Enables the first numVoices pool slots, stopping anything still sounding above them. Never allocates.
+    void setNumEnabledVoices (int numVoices);
+    int getNumEnabledVoices() const noexcept  { return numEnabledVoices; }
+    int getNumActiveVoices() const noexcept   { return numActiveVoices.load (std::memory_order_relaxed); }   // As of the end of the last block.
+
+    // Sizes the bank, its mono mix buffer and every voice's scratch buffer; call after all voices have been added.
+    // sampleRate and maximumBlockSize are at the render rate, i.e. already multiplied by any oversampling factor.
+    void prepare (double sampleRate, int maximumBlockSize);
+
+    // Retunes every voice to a new render rate without stopping the notes that are sounding, which
+    // juce::Synthesiser::setCurrentPlaybackSampleRate() would do. Voices pick it up at their next block.
+    void setRenderSampleRate (double newSampleRate);
+
+    // Switches every voice between the float kernels and the render engine's double ones. The voice bank only
+    // has float lanes, so high precision renders voice by voice.
+    void setHighPrecision (bool shouldUseHighPrecision);
+    bool isHighPrecision() const noexcept                    { return highPrecision; }
+
+    // Snapshot and restore of every pool voice's oscillator and filter state, into storage reserved by
+    // createVoicePool(). The processor uses them to render one block with two engines for a crossfade.
+    void saveVoiceStates() noexcept;
+    void restoreVoiceStates() noexcept;
+
+    // Replaces juce::Synthesiser::renderNextBlock(), which cuts every voice at every MIDI event. Here a note-on or
+    // note-off only cuts the voices it starts or stops, at its exact sample; voices no event touched render the
+    // block in one run, through the voice bank where enabled. Events that reach every voice (controllers, pitch
+    // wheel, pedals) are delayed where needed so that no run between two of them is shorter than the minimum
+    // sub-block size. A note event that follows such a delayed event but falls before its new position waits for
+    // it, so the note is only sample accurate when the minimum is 1 or no controller precedes it within the run.
+    void renderNextBlock (juce::AudioBuffer<float>& outputAudio, const juce::MidiBuffer& inputMidi, int startSample, int numSamples);
+    void renderNextBlock (juce::AudioBuffer<double>& outputAudio, const juce::MidiBuffer& inputMidi, int startSample, int numSamples);
+
+    // Multi-timbral mode: which parameters each MIDI channel's notes play with and where they are mixed. A change
+    // applies from the channel's next note-on; sounding notes finish as they started.
+    struct ChannelRouting
+    {
+        const SmoothedParameters* parameters = nullptr;   // Null for the synth's own.
+        bool appliesPartGain = false;                     // The parameters' gain scales each voice (see AntiAliasedVoice).
+        int firstOutputChannel = 0;
+        int numOutputChannels = -1;                       // -1 for every channel of the output.
+    };
+
+    void setChannelRouting (int midiChannel, const ChannelRouting& routing) noexcept;
+    void setMultiTimbral (bool shouldBeMultiTimbral) noexcept { multiTimbral = shouldBeMultiTimbral; }
+
+    // In render-rate samples. 1 makes every event sample accurate.
+    void setMinimumSubBlockSize (int numSamples) noexcept   { minimumSubBlockSize = juce::jmax (1, numSamples); }
+    int getMinimumSubBlockSize() const noexcept              { return minimumSubBlockSize; }
+
+    // Shortest run a controller split has cut since prepare(), in render-rate samples; 0 while none has. Runs the
+    // end of a block cuts short are left out.
+    int getShortestControllerRun() const noexcept { return shortestControllerRun.load (std::memory_order_relaxed); }
+
+    // Remembers MIDI pan (CC 10) per channel so notes started later inherit it.
+    void handleController (int midiChannel, int controllerNumber, int controllerValue) override;
+    void noteOn (int midiChannel, int midiNoteNumber, float velocity) override;
+    void noteOff (int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override;
+
+    // MPE, lower zone: each note's own channel bends it by up to the MPE Bend Range and carries its pressure and
+    // slide (CC 74); the master channel, 1, bends every note by up to 2 semitones, so a plain keyboard on channel 1
+    // bends as usual. Polyphonic aftertouch sets the pressure of its one key. None of these split voice runs.
+    // In multi-timbral mode every channel is a part of its own: its bend moves only its notes, by up to 2.
+    void handlePitchWheel (int midiChannel, int wheelValue) override;
+    void handleChannelPressure (int midiChannel, int channelPressureValue) override;
+    void handleAftertouch (int midiChannel, int midiNoteNumber, int aftertouchValue) override;
+
+    // Which sounding voice a note-on takes when every enabled slot is busy. Oldest prefers a released voice over
+    // a held one, oldest first; quietest takes the voice with the lowest current amplitude, oldest on a tie.
+    enum class StealingPolicy { oldest, quietest };
+    void setStealingPolicy (StealingPolicy newPolicy) noexcept   { stealingPolicy = newPolicy; }
+    StealingPolicy getStealingPolicy() const noexcept           { return stealingPolicy; }
+
+    void setVoiceBankEnabled (bool shouldBeEnabled) noexcept { voiceBankEnabled.store (shouldBeEnabled); }
+    bool isVoiceBankEnabled() const noexcept                 { return voiceBankEnabled.load(); }
+
+    // The voices' fused kernels, on by default; applied from the next block.
+    void setFusedKernelsEnabled (bool shouldBeEnabled) noexcept { fusedKernelsEnabled.store (shouldBeEnabled); }
+    bool areFusedKernelsEnabled() const noexcept                { return fusedKernelsEnabled.load(); }
+
+    // With workers, large voice counts are split across threads; call while audio is stopped. 0 disables it.
+    void setNumRenderWorkers (int numWorkers);
+    int getNumRenderWorkers() const noexcept                 { return renderPool.getNumWorkers(); }
+
+protected:
+    void renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+    void renderVoices (juce::AudioBuffer<double>& outputAudio, int startSample, int numSamples) override;
+
+private:
+    static constexpr int minVoicesForParallelRender = 4;
+    static constexpr int mpeMasterChannel = 1;
+    static constexpr float masterBendRange = 2.0f;
+
+    static bool isExpressionMessage (const juce::MidiMessage& message) noexcept;
+    float getBendSemitones (int midiChannel) const noexcept;
+    void sendExpression (int midiChannel, NoteExpression::Dimension dimension) noexcept;
+
+    void retireFinishedVoices() noexcept;
+    AntiAliasedVoice* getVoiceForNote (int midiChannel, int midiNoteNumber) const noexcept;
+    AntiAliasedVoice* chooseVoice (int midiChannel, int midiNoteNumber, bool stealIfNoneAvailable) noexcept;
+    AntiAliasedVoice* chooseVoiceToSteal() const noexcept;
+    template <typename SampleType>
+    void renderScheduled (juce::AudioBuffer<SampleType>& outputAudio, const juce::MidiBuffer& inputMidi, int startSample, int numSamples);
+    template <typename SampleType>
+    void catchUp (AntiAliasedVoice& voice, juce::AudioBuffer<SampleType>& outputAudio, int position);
+    template <typename SampleType>
+    void catchUpAll (juce::AudioBuffer<SampleType>& outputAudio, int position);
+    template <typename SampleType>
+    void renderVoiceList (juce::AudioBuffer<SampleType>& outputAudio, const std::vector<AntiAliasedVoice*>& voicesToRender,
+                          int startSample, int numSamples);
+    template <typename SampleType>
+    void renderVoicesInParallel (juce::AudioBuffer<SampleType>& outputAudio, int numActive, int startSample, int numSamples);
+
+    const SmoothedParameters* parameters = nullptr;
+    AntiAliasedVoice* voicePool = nullptr;   // Owned; the base class's voices array only borrows these.
+    int poolCapacity = 0;
+    int numEnabledVoices = 0;
+    VoiceAllocator allocator;                      // Free enabled slots and the slot sounding each key.
+    StealingPolicy stealingPolicy = StealingPolicy::oldest;
+    std::vector<AntiAliasedVoice*> activeVoices;   // Sounding voices in slot order, reserved to the pool size.
+    std::atomic<int> numActiveVoices { 0 };        // activeVoices.size() after each block, readable from any thread.
+    std::vector<int> renderPositions;              // Per pool slot: how far into the current block the voice has rendered.
+    std::vector<AntiAliasedVoice*> scheduledVoices;   // Voices still to render from the start of the current block.
+    int eventPosition = 0;                         // Sample of the event being dispatched; a voice it starts renders from here.
+    int minimumSubBlockSize = 32;
+    std::atomic<int> shortestControllerRun { 0 };   // See getShortestControllerRun().
+
+    PulseVoiceBank bank;
+    std::vector<AntiAliasedVoice*> bankVoices;   // Lane -> voice, so state can be scattered back after rendering.
+    juce::AudioBuffer<float> bankMix;
+    std::atomic<bool> voiceBankEnabled { true };
+    std::atomic<bool> fusedKernelsEnabled { true };
+    bool voicesUseFusedKernels = true;             // As last handed to the voices.
+    bool highPrecision = false;
+    std::vector<AntiAliasedVoice::RenderState> savedVoiceStates;   // Indexed by pool slot.
+    std::array<float, 16> channelPans {};
+    std::array<float, 16> channelBends {};      // -1 ... 1 of the channel's bend range.
+    std::array<float, 16> channelPressures {};
+    std::array<float, 16> channelSlideOffsets {};   // From NoteExpression::neutralSlide.
+    std::array<ChannelRouting, 16> channelRoutings {};
+    bool multiTimbral = false;
+
+    ParallelRenderPool renderPool;
+    std::vector<AntiAliasedVoice*> preparedVoices;   // The voices renderVoiceList() prepared for the run, in slot order.
+    int parallelChunkStart = 0;
+    int parallelChunkSize = 0;
+    int preparedBlockSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (AntiAliasedSynthesiser)
+};
@@ -0,0 +1,189 @@
+#include "UnisonOscillator.h"
+
+#include <cmath>
+
+namespace
+{
+void renderLayer (AntiAliasedPulseOscillator& layer, double* output, const float* pulseWidths, int numSamples) noexcept
+{
+    layer.processBlockPrecise (output, pulseWidths, numSamples);
+}
+
+void renderLayer (WavetablePulseOscillator& layer, double* output, const float* pulseWidths, int numSamples) noexcept
+{
+    layer.processBlockPrecise (output, pulseWidths, numSamples);
+}
+
+void renderLayer (WavetablePulseOscillator& layer, float* output, const float* pulseWidths, int numSamples) noexcept
+{
+    if (pulseWidths != nullptr)
+        layer.processBlock (output, pulseWidths, numSamples);
+    else
+        layer.processBlock (output, numSamples);
+}
+}
+
+void UnisonOscillator::setLayout (int newNumLayers, float newDetuneCents, float newSpread) noexcept
+{
+    newNumLayers = juce::jlimit (1, maxLayers, newNumLayers);
+    newDetuneCents = juce::jmax (0.0f, newDetuneCents);
+    newSpread = juce::jlimit (0.0f, 1.0f, newSpread);
+
+    if (newNumLayers == numLayers && newDetuneCents == detuneCents && newSpread == spread)
+        return;
+
+    numLayers = newNumLayers;
+    detuneCents = newDetuneCents;
+    spread = newSpread;
+    updateLayers();
+
+    if (sampleRate > 0.0)
+        setFrequency (frequency, sampleRate);
+}
+
+// Layer i sits at offset -1 ... 1 across the stack; the outer layers are the most detuned and the widest.
+void UnisonOscillator::updateLayers() noexcept
+{
+    const auto mixGain = 1.0f / std::sqrt (static_cast<float> (numLayers));
+
+    for (int i = 0; i < maxLayers; ++i)
+    {
+        const auto index = static_cast<size_t> (i);
+        const auto offset = numLayers > 1 ? ((2.0f * static_cast<float> (i)) / static_cast<float> (numLayers - 1)) - 1.0f : 0.0f;
+        const auto pan = offset * spread;
+
+        frequencyRatios[index] = std::exp2 (offset * detuneCents / 1200.0f);
+        leftGains[index] = i < numLayers ? mixGain * juce::jmin (1.0f, 1.0f - pan) : 0.0f;   // Same balance law as the voice pan.
+        rightGains[index] = i < numLayers ? mixGain * juce::jmin (1.0f, 1.0f + pan) : 0.0f;
+    }
+}
+
+void UnisonOscillator::setTables (const SawWavetables* newTables) noexcept
+{
+    for (auto& layer : tableLayers)
+        layer.setTables (newTables);
+}
+
+void UnisonOscillator::setFrequency (float newFrequency, double newSampleRate) noexcept
+{
+    frequency = newFrequency;
+    sampleRate = newSampleRate;
+
+    for (int i = 0; i < numLayers; ++i)
+    {
+        const auto index = static_cast<size_t> (i);
+        layers[index].setFrequency (frequency * frequencyRatios[index], sampleRate);
+        tableLayers[index].setFrequency (frequency * frequencyRatios[index], sampleRate);
+    }
+}
+
+void UnisonOscillator::setPulseWidth (float newPulseWidth) noexcept
+{
+    for (auto& layer : layers)
+        layer.setPulseWidth (newPulseWidth);
+
+    for (auto& layer : tableLayers)
+        layer.setPulseWidth (newPulseWidth);
+}
+
+void UnisonOscillator::reset() noexcept
+{
+    constexpr auto goldenRatioFraction = 0.6180339887498949;
+
+    for (int i = 0; i < maxLayers; ++i)
+    {
+        const auto index = static_cast<size_t> (i);
+        const auto startPhase = std::fmod (static_cast<double> (i) * goldenRatioFraction, 1.0);
+        layers[index].reset();
+        layers[index].leadingEdge.phase = startPhase;
+        tableLayers[index].setPhase (startPhase);
+    }
+}
+
+void UnisonOscillator::processBlock (float* left, float* right, const float* pulseWidths, float* workspace, int numSamples) noexcept
+{
+    if (engine == OscillatorEngine::wavetable)
+    {
+        mixLayers (tableLayers, left, right, pulseWidths, workspace, numSamples);
+        return;
+    }
+
+    render (left, right, pulseWidths, numSamples);
+
+    if (pulseWidths != nullptr && numSamples > 0)
+        setPulseWidth (pulseWidths[numSamples - 1]);
+}
+
+// The layers fill the first lanes of one group; the kernel mixes only those, in layer order.
+void UnisonOscillator::render (float* left, float* right, const float* pulseWidths, int numSamples) noexcept
+{
+    juce::FloatVectorOperations::clear (left, numSamples);
+
+    if (right != nullptr)
+        juce::FloatVectorOperations::clear (right, numSamples);
+
+    PulseBankGroup group {};
+
+    for (int lane = 0; lane < numLayers; ++lane)
+    {
+        const auto index = static_cast<size_t> (lane);
+        const auto& leading = layers[index].leadingEdge;
+        const auto& trailing = layers[index].trailingEdge;
+
+        group.leadingPhase[lane] = static_cast<float> (leading.phase);
+        group.leadingOsc[lane] = static_cast<float> (leading.osc);
+        group.leadingPrevious[lane] = static_cast<float> (leading.previousInput);
+        group.trailingPhase[lane] = static_cast<float> (trailing.phase);
+        group.trailingOsc[lane] = static_cast<float> (trailing.osc);
+        group.trailingPrevious[lane] = static_cast<float> (trailing.previousInput);
+        group.w[lane] = leading.w;
+        group.beta[lane] = leading.beta;
+        group.dc[lane] = leading.dc;
+        group.inverseNorm[lane] = leading.inverseNorm;
+        group.pulseWidth[lane] = layers[index].pulseWidth;
+        group.level[lane] = leftGains[index];
+        group.rightLevel[lane] = rightGains[index];
+    }
+
+    getActivePulseBankKernels().unison (group, numLayers, left, right, pulseWidths, numSamples);
+
+    for (int lane = 0; lane < numLayers; ++lane)
+    {
+        auto& layer = layers[static_cast<size_t> (lane)];
+        layer.leadingEdge.phase = group.leadingPhase[lane];
+        layer.leadingEdge.osc = group.leadingOsc[lane];
+        layer.leadingEdge.previousInput = group.leadingPrevious[lane];
+        layer.trailingEdge.phase = group.trailingPhase[lane];
+        layer.trailingEdge.osc = group.trailingOsc[lane];
+        layer.trailingEdge.previousInput = group.trailingPrevious[lane];
+    }
+}
+
+void UnisonOscillator::processBlockPrecise (double* left, double* right, const float* pulseWidths, double* workspace, int numSamples) noexcept
+{
+    if (engine == OscillatorEngine::wavetable)
+        mixLayers (tableLayers, left, right, pulseWidths, workspace, numSamples);
+    else
+        mixLayers (layers, left, right, pulseWidths, workspace, numSamples);
+}
+
+// Layer by layer through workspace, for the kernels that are not gathered into lanes.
+template <typename SampleType, typename Layer>
+void UnisonOscillator::mixLayers (std::array<Layer, maxLayers>& layersToMix, SampleType* left, SampleType* right,
+                                  const float* pulseWidths, SampleType* workspace, int numSamples) noexcept
+{
+    juce::FloatVectorOperations::clear (left, numSamples);
+
+    if (right != nullptr)
+        juce::FloatVectorOperations::clear (right, numSamples);
+
+    for (int i = 0; i < numLayers; ++i)
+    {
+        const auto index = static_cast<size_t> (i);
+        renderLayer (layersToMix[index], workspace, pulseWidths, numSamples);
+        juce::FloatVectorOperations::addWithMultiply (left, workspace, static_cast<SampleType> (leftGains[index]), numSamples);
+
+        if (right != nullptr)
+            juce::FloatVectorOperations::addWithMultiply (right, workspace, static_cast<SampleType> (rightGains[index]), numSamples);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Oscillators.h"
+#include "PulseBankKernels.h"
+#include "Wavetables.h"
+
+#include <array>
+
+//==============================================================================
+// Unison stack for one note: up to maxLayers detuned AntiAliasedPulseOscillator states, spread across the stereo
+// field and mixed down to a left/right pair before the voice's filter. The layers stay ordinary oscillator
+// objects; the float kernel gathers them into the lanes of a PulseBankGroup for the block, steps them through the
+// voice bank's kernels at the instruction set PulseVoiceBank chose and scatters the state back, so a full stack
+// costs two SSE/NEON registers per sample, or one AVX2 or AVX-512 register.
+// The wavetable engine keeps a second set of layers, rendered one after another: they have no feedback to hide.
+class UnisonOscillator final
+{
+public:
+    static constexpr int maxLayers = 8;
+
+    // Layers sit evenly across +-detuneCents around the note and, pan-wise, across +-spread of the stereo field.
+    // The mix is scaled by 1 / sqrt (numLayers), so a stack of uncorrelated layers is about as loud as one.
+    void setLayout (int numLayers, float detuneCents, float spread) noexcept;
+    int getNumLayers() const noexcept   { return numLayers; }
+    bool isStereo() const noexcept      { return numLayers > 1 && spread > 0.0f; }
+
+    void setTables (const SawWavetables* newTables) noexcept;
+    void setEngine (OscillatorEngine newEngine) noexcept { engine = newEngine; }
+
+    void setFrequency (float newFrequency, double newSampleRate) noexcept;   // Retunes every layer around it.
+    void setPulseWidth (float newPulseWidth) noexcept;
+
+    // Layers start at staggered phases, so a note doesn't begin with every layer lined up into one spike.
+    void reset() noexcept;
+
+    // Overwrites left with the mix, or left and right when right is non-null. pulseWidths may be null; workspace
+    // holds one layer at a time where the engine renders them one by one.
+    void processBlock (float* left, float* right, const float* pulseWidths, float* workspace, int numSamples) noexcept;
+
+    // The same through the engine's precise kernel.
+    void processBlockPrecise (double* left, double* right, const float* pulseWidths, double* workspace, int numSamples) noexcept;
+
+private:
+    static_assert (maxLayers <= PulseBankGroup::numLanes, "the stack must fit one lane group");
+
+    void render (float* left, float* right, const float* pulseWidths, int numSamples) noexcept;
+    template <typename SampleType, typename Layer>
+    void mixLayers (std::array<Layer, maxLayers>& layersToMix, SampleType* left, SampleType* right, const float* pulseWidths,
+                    SampleType* workspace, int numSamples) noexcept;
+    void updateLayers() noexcept;
+
+    std::array<AntiAliasedPulseOscillator, maxLayers> layers;
+    std::array<WavetablePulseOscillator, maxLayers> tableLayers;
+    OscillatorEngine engine = OscillatorEngine::feedbackFm;
+    std::array<float, maxLayers> frequencyRatios {};
+    std::array<float, maxLayers> leftGains {}, rightGains {};   // Both hold the plain mix gain when mono.
+    int numLayers = 1;
+    float detuneCents = 0.0f;
+    float spread = 0.0f;
+    float frequency = 0.0f;
+    double sampleRate = 0.0;
+};
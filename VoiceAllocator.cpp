@@ -0,0 +1,79 @@
+#include "VoiceAllocator.h"
+
+#include <algorithm>
+
+void VoiceAllocator::prepare (int capacity)
+{
+    capacity = std::max (0, capacity);
+
+    freeSlots.clear();
+    freeSlots.reserve (static_cast<size_t> (capacity));
+    slotKeys.assign (static_cast<size_t> (capacity), -1);
+    keySlots.fill (-1);
+
+    setNumEnabledSlots (capacity);
+
+    // Pushed from the top down, so the lowest slot goes first, as the old first-idle-voice scan did.
+    for (int slot = capacity; --slot >= 0;)
+        addFreeSlot (slot);
+}
+
+void VoiceAllocator::setNumEnabledSlots (int numSlots) noexcept
+{
+    numEnabledSlots = std::clamp (numSlots, 0, static_cast<int> (slotKeys.size()));
+    freeSlots.clear();
+}
+
+void VoiceAllocator::addFreeSlot (int slot) noexcept
+{
+    if (slot >= 0 && slot < numEnabledSlots && freeSlots.size() < freeSlots.capacity())
+        freeSlots.push_back (slot);
+}
+
+int VoiceAllocator::getSlotForNote (int midiChannel, int midiNoteNumber) const noexcept
+{
+    const auto key = keyFor (midiChannel, midiNoteNumber);
+    return key >= 0 ? keySlots[static_cast<size_t> (key)] : -1;
+}
+
+void VoiceAllocator::assign (int slot, int midiChannel, int midiNoteNumber) noexcept
+{
+    if (slot < 0 || slot >= static_cast<int> (slotKeys.size()))
+        return;
+
+    // Free slots are only ever handed out from the top of the stack.
+    if (! freeSlots.empty() && freeSlots.back() == slot)
+        freeSlots.pop_back();
+
+    auto& slotKey = slotKeys[static_cast<size_t> (slot)];
+
+    if (slotKey >= 0 && keySlots[static_cast<size_t> (slotKey)] == slot)
+        keySlots[static_cast<size_t> (slotKey)] = -1;
+
+    slotKey = keyFor (midiChannel, midiNoteNumber);
+
+    if (slotKey >= 0)
+        keySlots[static_cast<size_t> (slotKey)] = slot;
+}
+
+void VoiceAllocator::release (int slot) noexcept
+{
+    if (slot < 0 || slot >= static_cast<int> (slotKeys.size()))
+        return;
+
+    auto& slotKey = slotKeys[static_cast<size_t> (slot)];
+
+    if (slotKey >= 0 && keySlots[static_cast<size_t> (slotKey)] == slot)
+        keySlots[static_cast<size_t> (slotKey)] = -1;
+
+    slotKey = -1;
+    addFreeSlot (slot);
+}
+
+int VoiceAllocator::keyFor (int midiChannel, int midiNoteNumber) noexcept
+{
+    if (midiChannel < 1 || midiChannel > numChannels || midiNoteNumber < 0 || midiNoteNumber >= numNotes)
+        return -1;
+
+    return ((midiChannel - 1) * numNotes) + midiNoteNumber;
+}
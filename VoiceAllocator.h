@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+//==============================================================================
+// Slot bookkeeping for AntiAliasedSynthesiser's voice pool: a stack of the enabled slots that are free, and for
+// every MIDI channel/note the slot sounding it. Each key is held by at most one slot, since a retriggered note
+// reuses its voice. Every query is an array lookup; storage is reserved in prepare(), so nothing allocates later.
+class VoiceAllocator final
+{
+public:
+    static constexpr int numChannels = 16;
+    static constexpr int numNotes = 128;
+
+    // Makes every slot below capacity enabled and free.
+    void prepare (int capacity);
+
+    // Enables the slots below numSlots with an empty free list; the caller hands back the idle ones with addFreeSlot().
+    void setNumEnabledSlots (int numSlots) noexcept;
+    void addFreeSlot (int slot) noexcept;
+
+    // The slot the next note would get without stealing, or -1.
+    int getFreeSlot() const noexcept    { return freeSlots.empty() ? -1 : freeSlots.back(); }
+
+    // The slot sounding the key, or -1.
+    int getSlotForNote (int midiChannel, int midiNoteNumber) const noexcept;
+
+    // Slot now plays the key: it leaves the free list if it was on it, and whatever key it held before is dropped.
+    void assign (int slot, int midiChannel, int midiNoteNumber) noexcept;
+
+    // The slot's voice has gone idle: its key is forgotten and, while still enabled, it becomes free again.
+    void release (int slot) noexcept;
+
+private:
+    static int keyFor (int midiChannel, int midiNoteNumber) noexcept;   // -1 outside channels 1-16 / notes 0-127.
+
+    std::vector<int> freeSlots;                          // Top is handed out first; reserved to the pool size.
+    std::vector<int> slotKeys;                           // Per slot: the key it plays, or -1.
+    std::array<int, numChannels * numNotes> keySlots;    // Per key: the slot playing it, or -1.
+    int numEnabledSlots = 0;
+};
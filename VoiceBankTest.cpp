@@ -0,0 +1,432 @@
+#include "PluginProcessor.h"
+#include "ParameterIDs.h"
+#include "PulseVoiceBank.h"
+#include "UnisonOscillator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Checks that the voice bank renders exactly what the scalar voices render, at every instruction set this build
+// and CPU can run. Registered with CTest (see CMakeLists.txt); nothing here runs in the plugin.
+//
+//   lanes     : PulseVoiceBank against one AntiAliasedPulseOscillator plus LowPassBiquad or LowPassSvf per voice,
+//               over blocks with constant and ramped pulse widths and SVF cutoffs. Must match bit for bit.
+//   unison    : UnisonOscillator stacks, mono and spread, at each instruction set against the same stack rendered
+//               at the baseline. The kernels mix the layers in layer order, so they must match bit for bit.
+//   processor : AudioPluginAudioProcessor with the voice bank on against the bank off, the latter with the fused
+//               and the separate voice kernels, playing a held chord through a parameter sweep and its release.
+//               Must match bit for bit: every note is at the same envelope stage, so either every voice is banked
+//               or none is, and the mix adds the voices in the same order.
+//   staggered : the same with notes starting and ending at different times. Banked and unbanked voices then sum
+//               in a different order, so the outputs may differ by float rounding; they must stay within
+//               staggeredTolerance (-80 dBFS), far below anything a wrong lane or lost state would produce.
+//
+// Exit codes: 0 = every comparison matched, 1 = a mismatch.
+
+namespace
+{
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+constexpr float staggeredTolerance = 1.0e-4f;
+
+const PulseVoiceBank::InstructionSet instructionSets[] { PulseVoiceBank::InstructionSet::baseline,
+                                                         PulseVoiceBank::InstructionSet::avx2,
+                                                         PulseVoiceBank::InstructionSet::avx512 };
+
+// Tallies one comparison and prints it with the first sample that is out of tolerance.
+class Comparison
+{
+public:
+    Comparison (const juce::String& nameToUse, float toleranceToUse) : name (nameToUse), tolerance (toleranceToUse) {}
+
+    void check (const float* expected, const float* actual, int numSamples, int firstSampleIndex) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto difference = std::abs (expected[i] - actual[i]);
+            maxDifference = juce::jmax (maxDifference, difference);
+
+            // Also catches a NaN on either side, which compares unequal to everything.
+            if (! (difference <= tolerance))
+            {
+                if (numMismatches++ == 0)
+                    firstMismatch = { firstSampleIndex + i, expected[i], actual[i] };
+            }
+        }
+
+        numSamplesChecked += numSamples;
+    }
+
+    bool report() const
+    {
+        std::printf ("  %-56s %8d samples  max difference %.3g  %s\n", name.toRawUTF8(), numSamplesChecked,
+                     static_cast<double> (maxDifference), numMismatches == 0 ? "ok" : "FAILED");
+
+        if (numMismatches > 0)
+            std::printf ("    %d samples out of tolerance %.3g; first at %d: expected %.9g, got %.9g\n", numMismatches,
+                         static_cast<double> (tolerance), firstMismatch.index, static_cast<double> (firstMismatch.expected),
+                         static_cast<double> (firstMismatch.actual));
+
+        return numMismatches == 0;
+    }
+
+private:
+    struct Mismatch
+    {
+        int index = 0;
+        float expected = 0.0f, actual = 0.0f;
+    };
+
+    juce::String name;
+    float tolerance;
+    float maxDifference = 0.0f;
+    int numSamplesChecked = 0;
+    int numMismatches = 0;
+    Mismatch firstMismatch;
+};
+
+//==============================================================================
+enum class LaneFilter { biquad, svf, svfRamp };
+
+const char* getName (LaneFilter filter) noexcept
+{
+    switch (filter)
+    {
+        case LaneFilter::biquad:  return "biquad";
+        case LaneFilter::svf:     return "svf";
+        case LaneFilter::svfRamp: return "svf ramp";
+    }
+
+    return {};
+}
+
+LowPassSvf::Coefficients getSvfCoefficients (double cutoff) noexcept
+{
+    return LowPassSvf::Coefficients::fromG (static_cast<float> (std::tan (juce::MathConstants<double>::pi * cutoff / sampleRate)));
+}
+
+// numVoices detuned voices with their own widths, levels and biquad cutoffs, rendered block by block through the
+// bank and one at a time. Odd blocks ramp the width past both ends of its range to cover the clamp.
+bool compareLanes (int numVoices, LaneFilter filter)
+{
+    constexpr int numBlocks = 8;
+    const auto voices = static_cast<size_t> (numVoices);
+
+    std::vector<AntiAliasedPulseOscillator> scalarOscillators (voices), bankOscillators (voices);
+    std::vector<LowPassBiquad> scalarBiquads (voices), bankBiquads (voices);
+    std::vector<LowPassSvf> scalarSvfs (voices), bankSvfs (voices);
+    std::vector<float> levels (voices);
+
+    const auto svfCoefficients = getSvfCoefficients (1800.0);
+
+    for (size_t i = 0; i < voices; ++i)
+    {
+        const auto frequency = 41.0f * (1.0f + 0.37f * static_cast<float> (i));
+        const auto width = 0.1f + 0.8f * static_cast<float> (i) / static_cast<float> (voices);
+        const auto biquadCoefficients = juce::IIRCoefficients::makeLowPass (sampleRate, 600.0 + 350.0 * static_cast<double> (i));
+
+        for (auto* oscillator : { &scalarOscillators[i], &bankOscillators[i] })
+        {
+            oscillator->setFrequency (frequency, sampleRate);
+            oscillator->setPulseWidth (width);
+        }
+
+        scalarBiquads[i].setCoefficients (biquadCoefficients);
+        bankBiquads[i].setCoefficients (biquadCoefficients);
+        scalarSvfs[i].setCoefficients (svfCoefficients);
+        bankSvfs[i].setCoefficients (svfCoefficients);
+        levels[i] = 0.2f + 0.6f * static_cast<float> (i) / static_cast<float> (voices);
+    }
+
+    std::vector<float> widthRamp (blockSize), expected (blockSize), actual (blockSize), voiceOutput (blockSize);
+    std::vector<LowPassSvf::Coefficients> svfRamp (blockSize);
+
+    for (int i = 0; i < blockSize; ++i)
+    {
+        const auto position = static_cast<float> (i) / static_cast<float> (blockSize - 1);
+        widthRamp[(size_t) i] = -0.1f + 1.2f * position;
+        svfRamp[(size_t) i] = getSvfCoefficients (300.0 + 9000.0 * static_cast<double> (position));
+    }
+
+    PulseVoiceBank bank;
+    bank.prepare (numVoices);
+
+    Comparison comparison (juce::String (numVoices) + " voices, " + getName (filter) + ", "
+                               + PulseVoiceBank::getName (PulseVoiceBank::getInstructionSet()),
+                           0.0f);
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        const auto* widths = block % 2 == 1 ? widthRamp.data() : nullptr;
+        const auto* coefficientRamp = filter == LaneFilter::svfRamp ? svfRamp.data() : nullptr;
+
+        std::fill (expected.begin(), expected.end(), 0.0f);
+        std::fill (actual.begin(), actual.end(), 0.0f);
+
+        for (size_t i = 0; i < voices; ++i)
+        {
+            auto* samples = voiceOutput.data();
+
+            if (widths != nullptr)
+                scalarOscillators[i].processBlock (samples, widths, blockSize);
+            else
+                scalarOscillators[i].processBlock (samples, blockSize);
+
+            for (int s = 0; s < blockSize; ++s)
+                samples[s] *= levels[i];
+
+            if (filter == LaneFilter::biquad)
+                scalarBiquads[i].processBlock (samples, blockSize);
+            else if (coefficientRamp != nullptr)
+                scalarSvfs[i].processBlock (samples, coefficientRamp, blockSize);
+            else
+                scalarSvfs[i].processBlock (samples, blockSize);
+
+            for (int s = 0; s < blockSize; ++s)
+                expected[(size_t) s] += samples[s];
+        }
+
+        bank.clear();
+
+        for (size_t i = 0; i < voices; ++i)
+        {
+            if (filter == LaneFilter::biquad)
+                bank.add (bankOscillators[i], bankBiquads[i], levels[i]);
+            else
+                bank.add (bankOscillators[i], bankSvfs[i], levels[i]);
+        }
+
+        if (filter == LaneFilter::biquad)
+            bank.process (actual.data(), widths, blockSize);
+        else
+            bank.process (actual.data(), widths, svfCoefficients, coefficientRamp, blockSize);
+
+        for (int lane = 0; lane < bank.getNumVoices(); ++lane)
+        {
+            const auto i = static_cast<size_t> (lane);
+
+            if (filter == LaneFilter::biquad)
+                bank.store (lane, bankOscillators[i], bankBiquads[i]);
+            else
+                bank.store (lane, bankOscillators[i], bankSvfs[i]);
+
+            // The bank leaves the width alone; the oscillator's ramp overload ends on the ramp's last value.
+            if (widths != nullptr)
+                bankOscillators[i].setPulseWidth (widths[blockSize - 1]);
+        }
+
+        comparison.check (expected.data(), actual.data(), blockSize, block * blockSize);
+    }
+
+    return comparison.report();
+}
+
+// A stack of numLayers rendered block by block at the active instruction set and at the baseline, with every
+// odd block ramping the width.
+bool compareUnison (int numLayers, bool stereo)
+{
+    constexpr int numBlocks = 8;
+    const auto activeSet = PulseVoiceBank::getInstructionSet();
+
+    const auto render = [&] (PulseVoiceBank::InstructionSet set)
+    {
+        PulseVoiceBank::setInstructionSet (set);
+
+        UnisonOscillator unison;
+        unison.setLayout (numLayers, 23.0f, stereo ? 0.8f : 0.0f);
+        unison.setFrequency (97.0f, sampleRate);
+        unison.setPulseWidth (0.3f);
+        unison.reset();
+
+        std::vector<float> widthRamp (blockSize), workspace (blockSize), output (2 * numBlocks * blockSize);
+
+        for (int i = 0; i < blockSize; ++i)
+            widthRamp[(size_t) i] = 0.05f + 0.9f * static_cast<float> (i) / static_cast<float> (blockSize - 1);
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto* left = output.data() + block * blockSize;
+            auto* right = stereo ? left + numBlocks * blockSize : nullptr;
+
+            unison.processBlock (left, right, block % 2 == 1 ? widthRamp.data() : nullptr, workspace.data(), blockSize);
+        }
+
+        return output;
+    };
+
+    const auto expected = render (PulseVoiceBank::InstructionSet::baseline);
+    const auto actual = render (activeSet);
+
+    Comparison comparison (juce::String (numLayers) + (stereo ? " layers, spread, " : " layers, mono, ")
+                               + PulseVoiceBank::getName (activeSet),
+                           0.0f);
+    comparison.check (expected.data(), actual.data(), static_cast<int> (expected.size()), 0);
+    return comparison.report();
+}
+
+//==============================================================================
+void setParameter (AudioPluginAudioProcessor& processor, const char* parameterID, float value)
+{
+    if (auto* parameter = processor.getValueTreeState().getParameter (parameterID))
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+enum class VoicePath { bank, fused, unfused };
+
+const char* getName (VoicePath path) noexcept
+{
+    switch (path)
+    {
+        case VoicePath::bank:    return "voice bank";
+        case VoicePath::fused:   return "scalar fused";
+        case VoicePath::unfused: return "scalar unfused";
+    }
+
+    return {};
+}
+
+// numNotes notes on channel 1, as blocks of stereo output one after the other. A held chord starts every note in
+// block 0 and releases them together; staggered starts and releases each note at a time of its own. Both sweep the
+// pulse width and cutoff a third of the way in, so the voices see the shared ramps.
+juce::AudioBuffer<float> renderProcessor (VoicePath path, int filterType, int numNotes, bool staggered)
+{
+    constexpr int numBlocks = 120;
+
+    AudioPluginAudioProcessor processor;
+    processor.setVoiceBankEnabled (path == VoicePath::bank);
+    processor.setFusedKernelsEnabled (path != VoicePath::unfused);
+    setParameter (processor, polyphonyParamID, static_cast<float> (numNotes));
+    setParameter (processor, filterTypeParamID, static_cast<float> (filterType));
+
+    processor.setPlayConfigDetails (0, 2, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    juce::AudioBuffer<float> output (2, numBlocks * blockSize);
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::MidiBuffer midi;
+
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        midi.clear();
+
+        for (int note = 0; note < numNotes; ++note)
+        {
+            const auto key = 30 + 4 * note;
+            const auto startBlock = staggered ? note % 7 : 0;
+            const auto endBlock = staggered ? 60 + 3 * note : 80;
+            const auto position = staggered ? (37 * note) % blockSize : 0;
+
+            if (block == startBlock)
+                midi.addEvent (juce::MidiMessage::noteOn (1, key, 0.8f), position);
+            else if (block == endBlock)
+                midi.addEvent (juce::MidiMessage::noteOff (1, key), position);
+        }
+
+        if (block == numBlocks / 3)
+        {
+            setParameter (processor, pulseWidthParamID, 0.2f);
+            setParameter (processor, filterCutoffParamID, 0.8f);
+        }
+
+        processor.processBlock (buffer, midi);
+
+        for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            output.copyFrom (channel, block * blockSize, buffer, channel, 0, blockSize);
+    }
+
+    processor.releaseResources();
+    return output;
+}
+
+bool compareProcessors (int filterType, int numNotes, bool staggered)
+{
+    const auto scalar = renderProcessor (VoicePath::fused, filterType, numNotes, staggered);
+    const auto description = juce::String (numNotes) + (staggered ? " staggered notes, " : " held notes, ")
+                           + (filterType == 0 ? "biquad" : "svf") + ", ";
+    auto passed = true;
+
+    const auto compare = [&] (const juce::AudioBuffer<float>& other, const juce::String& name, float tolerance)
+    {
+        Comparison comparison (description + name, tolerance);
+
+        for (int channel = 0; channel < scalar.getNumChannels(); ++channel)
+            comparison.check (scalar.getReadPointer (channel), other.getReadPointer (channel), scalar.getNumSamples(), 0);
+
+        passed = comparison.report() && passed;
+    };
+
+    // The fused kernels claim the separate passes' arithmetic in the same order, so they must agree exactly.
+    compare (renderProcessor (VoicePath::unfused, filterType, numNotes, staggered),
+             juce::String (getName (VoicePath::unfused)) + " vs " + getName (VoicePath::fused), 0.0f);
+
+    for (const auto set : instructionSets)
+    {
+        if (! PulseVoiceBank::setInstructionSet (set))
+            continue;
+
+        compare (renderProcessor (VoicePath::bank, filterType, numNotes, staggered),
+                 juce::String (getName (VoicePath::bank)) + " (" + PulseVoiceBank::getName (set) + ") vs " + getName (VoicePath::fused),
+                 staggered ? staggeredTolerance : 0.0f);
+    }
+
+    return passed;
+}
+}
+
+//==============================================================================
+int main()
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;   // The processor's parameter state needs a message manager.
+    const auto selectedSet = PulseVoiceBank::getInstructionSet();
+    auto passed = true;
+
+    // A pass only covers the sets listed here, so say which ones this build and CPU leave out.
+    std::printf ("%s, instruction sets:", juce::SystemStats::getJUCEVersion().toRawUTF8());
+
+    for (const auto set : instructionSets)
+        std::printf (" %s%s", PulseVoiceBank::getName (set), PulseVoiceBank::setInstructionSet (set) ? "" : " (skipped)");
+
+    std::printf ("\n\nVoice bank lanes against scalar oscillators and filters\n");
+
+    for (const auto set : instructionSets)
+    {
+        if (! PulseVoiceBank::setInstructionSet (set))
+            continue;
+
+        // One voice, a part-filled register, exactly one register at each width and lanes spilling into a second group.
+        for (const auto numVoices : { 1, 3, 4, 7, 8, 16, 17, 33 })
+            for (const auto filter : { LaneFilter::biquad, LaneFilter::svf, LaneFilter::svfRamp })
+                passed = compareLanes (numVoices, filter) && passed;
+    }
+
+    std::printf ("\nUnison stacks against the baseline kernels\n");
+
+    for (const auto set : instructionSets)
+    {
+        if (! PulseVoiceBank::setInstructionSet (set))
+            continue;
+
+        for (const auto numLayers : { 1, 3, 8 })
+        {
+            passed = compareUnison (numLayers, false) && passed;
+            passed = compareUnison (numLayers, true) && passed;
+        }
+    }
+
+    std::printf ("\nProcessor with the voice bank against the scalar voices\n");
+
+    for (const auto filterType : { 0, 1 })
+    {
+        for (const auto numNotes : { 7, 24 })
+        {
+            passed = compareProcessors (filterType, numNotes, false) && passed;
+            passed = compareProcessors (filterType, numNotes, true) && passed;
+        }
+    }
+
+    PulseVoiceBank::setInstructionSet (selectedSet);
+
+    std::printf ("\n%s\n", passed ? "All comparisons passed" : "Some comparisons FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+// Band-limited sawtooth tables, one per octave of normalised frequency ("mip-maps"). Level k holds the first 2^k
+// harmonics, so at any frequency up to its top, 0.5 / 2^k cycles per sample, nothing lies above Nyquist. The
+// tables depend only on cycles per sample, never on the sample rate, so one set serves every rate and factor.
+class SawWavetables final
+{
+public:
+    static constexpr int tableSize = 2048;
+    static constexpr int numLevels = 11;   // 1 ... 1024 harmonics; the last level covers everything below.
+
+    // Builds every level additively. Each level adds its octave of harmonics to the one above, so the whole set
+    // costs tableSize * 1024 table-lookup multiply-adds rather than that per level.
+    SawWavetables();
+
+    // tableSize + 1 samples of one rising cycle, -1 to 1; the extra sample repeats the first for interpolation.
+    const float* getLevel (int level) const noexcept   { return samples.data() + (static_cast<size_t> (level) * stride); }
+
+    // The level with the most harmonics that still fit below Nyquist at w cycles per sample.
+    static int levelFor (float w) noexcept;
+
+private:
+    static constexpr size_t stride = tableSize + 1;
+    std::vector<float> samples;
+};
+
+//==============================================================================
+// Pulse from two band-limited saws a pulse width apart, read from SawWavetables with linear interpolation.
+// Same interface and output range as AntiAliasedPulseOscillator, but each sample is two table reads with no
+// transcendental maths and no feedback; the table level is picked per block from the frequency.
+class WavetablePulseOscillator final
+{
+public:
+    void setTables (const SawWavetables* newTables) noexcept   { tables = newTables; updateLevel(); }
+    bool hasTables() const noexcept                             { return tables != nullptr; }
+
+    void setFrequency (float newFrequency, double newSampleRate) noexcept;
+    void setPulseWidth (float newPulseWidth) noexcept;
+    void processBlock (float* output, int numSamples) noexcept;
+    void processBlock (float* output, const float* pulseWidths, int numSamples) noexcept;   // Per-sample pulse width.
+    void reset() noexcept                                       { phase = 0.0; }
+
+    // Per-sample pulse width and multiplier of the set frequency. The block reads the level for its highest pitch.
+    void processBlock (float* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept;
+
+    // Double phase and interpolation; the tables themselves stay float. pulseWidths may be null.
+    void processBlockPrecise (double* output, const float* pulseWidths, int numSamples) noexcept;
+    void processBlockPrecise (double* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept;
+
+    void setPhase (double newPhase) noexcept                    { phase = newPhase - std::floor (newPhase); }
+
+private:
+    template <typename SampleType, bool hasWidthRamp, bool hasPitchRamp>
+    void render (SampleType* output, const float* pulseWidths, const float* pitchRatios, int numSamples) noexcept;
+    void updateLevel() noexcept;
+
+    const SawWavetables* tables = nullptr;
+    const float* table = nullptr;   // Level for the current frequency; null until tables are set.
+    double phase = 0.0;
+    float w = 0.0f;
+    float pulseWidth = 0.5f;
+};